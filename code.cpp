@@ -9,6 +9,36 @@
 #include <ctime>
 #include <iomanip>
 #include <sstream>
+#include <cstring>
+#include <cmath>
+#include <random>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <deque>
+#include <atomic>
+#include <fstream>
+#include <cstdint>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <new>
+#include <memory_resource>
+#include <array>
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
 
 using namespace std;
 
@@ -21,6 +51,37 @@ string minutesToTime(int mins)
     oss << setw(2) << setfill('0') << h << ":" << setw(2) << setfill('0') << m;
     return oss.str();
 }
+// Swallows console output while benchmarks drive the printing APIs
+class NullBuffer : public streambuf
+{
+protected:
+    int overflow(int c) { return c; }
+    streamsize xsputn(const char *, streamsize n) { return n; }
+};
+
+// Appends output to a string the caller owns and reuses
+class StringSink : public streambuf
+{
+public:
+    explicit StringSink(string &s) : target(s) {}
+
+protected:
+    int overflow(int c)
+    {
+        if (c != EOF)
+            target.push_back((char)c);
+        return c;
+    }
+    streamsize xsputn(const char *s, streamsize n)
+    {
+        target.append(s, n);
+        return n;
+    }
+
+private:
+    string &target;
+};
+
 void clearConsole()
 {
 #ifdef _WIN32
@@ -30,1020 +91,7769 @@ void clearConsole()
 #endif
 }
 
-// ---------------------- User Management ----------------------
-class User
+// ---------------------- Heap Allocation Counter ----------------------
+// Counts global operator new calls per thread, so the metrics report can
+// show allocations per call; warmed-up query paths should read zero. Build
+// with -DFLIGHTEASE_ALLOC_COUNTERS=0 to leave the allocator untouched.
+#ifndef FLIGHTEASE_ALLOC_COUNTERS
+#define FLIGHTEASE_ALLOC_COUNTERS 1
+#endif
+
+#if FLIGHTEASE_ALLOC_COUNTERS
+thread_local uint64_t threadHeapAllocations = 0;
+
+// Out of line so GCC does not pair the malloc()/free() inside and warn
+__attribute__((noinline)) void *operator new(size_t n)
 {
-public:
-    string username, password;
-    User(string u, string p) : username(u), password(p) {}
-    virtual ~User() {}
-};
+    threadHeapAllocations++;
+    if (void *p = malloc(n ? n : 1))
+        return p;
+    throw bad_alloc();
+}
+__attribute__((noinline)) void operator delete(void *p) noexcept { free(p); }
+__attribute__((noinline)) void operator delete(void *p, size_t) noexcept { free(p); }
+#endif
 
-class Passenger : public User
+uint64_t heapAllocations()
 {
-public:
-    string name;
-    vector<int> bookings; // flightIDs
-    Passenger() : User("test", "test"), name("test") {}
-    Passenger(string u, string p, string n) : User(u, p), name(n) {}
-};
+#if FLIGHTEASE_ALLOC_COUNTERS
+    return threadHeapAllocations;
+#else
+    return 0;
+#endif
+}
 
-class Admin : public User
+// ---------------------- Request Arena ----------------------
+// Per-thread bump allocator for temporaries that die with the request.
+// pmr containers built on an ArenaScope's resource() carve memory out of a
+// 64 KiB block and never free it piecemeal; the outermost scope rewinds the
+// block on exit. A warmed-up request therefore makes no heap allocations,
+// and one that outgrows the block spills to operator new, where the
+// allocation counter sees it.
+class RequestArena
 {
 public:
-    Admin() : User("test", "test") {}
-    Admin(string u, string p) : User(u, p) {}
+    static RequestArena &local()
+    {
+        static thread_local RequestArena arena;
+        return arena;
+    }
+
+private:
+    friend class ArenaScope;
+    static constexpr size_t BLOCK_BYTES = 64 * 1024;
+    unique_ptr<char[]> block;
+    pmr::monotonic_buffer_resource resource;
+    int depth = 0;
+
+    RequestArena() : block(new char[BLOCK_BYTES]), resource(block.get(), BLOCK_BYTES, pmr::new_delete_resource()) {}
 };
 
-// ---------------------- Crew Management ----------------------
-struct CrewMember
+// Declare before the containers that use it, so they are gone by the rewind
+class ArenaScope
 {
-    int id;
-    string name;
-    string role; // "Pilot", "Co-Pilot", "Attendant"
-    set<int> assignedFlights;
-    CrewMember() : id(0), name(""), role("") {}
-    CrewMember(int i, string n, string r) : id(i), name(n), role(r) {}
+public:
+    ArenaScope() : arena(RequestArena::local()) { arena.depth++; }
+    ~ArenaScope()
+    {
+        if (--arena.depth == 0)
+            arena.resource.release();
+    }
+    pmr::memory_resource *resource() const { return &arena.resource; }
+
+private:
+    RequestArena &arena;
 };
 
-// ---------------------- Flight and Booking ----------------------
-struct Booking
+// ---------------------- Operation Metrics ----------------------
+// Call counters and log-linear latency histograms for every public
+// AirlinesSystem operation. Each thread records into its own slab with
+// relaxed atomics (no sharing, no locks); reports sum the slabs. Build with
+// -DFLIGHTEASE_METRICS=0 to compile all of it out.
+#ifndef FLIGHTEASE_METRICS
+#define FLIGHTEASE_METRICS 1
+#endif
+
+enum Operation
 {
-    string passengerUsername;
-    int seatNo;
-    bool active;
-    Booking(string u, int s) : passengerUsername(u), seatNo(s), active(true) {}
+    OP_REGISTER,
+    OP_LOGIN,
+    OP_ADD_FLIGHT,
+    OP_REMOVE_FLIGHT,
+    OP_UPDATE_FLIGHT,
+    OP_LIST_FLIGHTS,
+    OP_SET_LOCATION,
+    OP_ADD_CREW,
+    OP_ASSIGN_CREW,
+    OP_LIST_CREW,
+    OP_CREW_VACANCY,
+    OP_SEARCH_ROUTE,
+    OP_SEARCH_TIME,
+    OP_BOOK,
+    OP_CANCEL,
+    OP_LIST_BOOKINGS,
+    OP_SHORTEST_ROUTE,
+    OP_CHEAPEST_ROUTE,
+    OP_REACHABLE,
+    OP_BATCH_ROUTES,
+    OP_OCCUPANCY_REPORT,
+    OP_WAITLIST_REPORT,
+    OP_PRINT_DUTIES,
+    OP_HOLD,
+    OP_CONFIRM_HOLD,
+    OP_RELEASE_HOLD,
+    OP_BOOK_GROUP,
+    OP_BOOK_ITINERARY,
+    OP_QUALIFY_CREW,
+    OP_CREW_REQUIREMENTS,
+    OP_QUERY_FLIGHTS,
+    OP_DELAY_FLIGHT,
+    OP_COUNT
 };
 
-struct Flight
+const char *OPERATION_NAMES[OP_COUNT] = {
+    "registerPassenger", "login", "addFlight", "removeFlight", "updateFlight", "listFlights",
+    "setAirportLocation", "addCrew", "assignCrewToAllFlights", "listCrew", "checkCrewVacancy",
+    "searchFlights", "searchFlightsByTime", "bookFlight", "cancelBooking", "listPassengerBookings",
+    "findShortestRoute", "findCheapestRoute", "reachableFrom", "batchRoutes",
+    "flightOccupancyReport", "waitlistReport", "printAllDuties", "holdSeat", "confirmHold", "releaseHold",
+    "bookGroup", "bookItinerary", "qualifyCrew", "setCrewRequirements", "queryFlights", "delayFlight"};
+
+// Values below 8 ns get exact buckets; above that every power of two is
+// split into 8 sub-buckets, so a bucket is at most 12.5% wide.
+struct LatencyHistogram
 {
-    int flightID;
-    string source;
-    string destination;
-    int departureTime; // minutes from midnight
-    int arrivalTime;
-    int seatsTotal;
-    int seatsAvailable;
-    vector<bool> seatMap;
-    vector<Booking> bookings;
-    queue<string> waitlist;
-    double basePrice;
-    vector<int> crewAssigned; // crew IDs
+    static constexpr int SUB_BUCKETS = 8;
+    static constexpr int BUCKETS = SUB_BUCKETS + 61 * SUB_BUCKETS;
 
-    Flight(int id, string src, string dest, int dep, int arr, int seats, double price)
-        : flightID(id), source(src), destination(dest), departureTime(dep),
-          arrivalTime(arr), seatsTotal(seats), seatsAvailable(seats),
-          seatMap(seats, false), basePrice(price) {}
+    static int bucketOf(uint64_t v)
+    {
+        if (v < SUB_BUCKETS)
+            return v;
+        int e = 63 - __builtin_clzll(v); // e >= 3
+        return SUB_BUCKETS + (e - 3) * SUB_BUCKETS + ((v >> (e - 3)) & (SUB_BUCKETS - 1));
+    }
+    static uint64_t upperBound(int b)
+    {
+        if (b < SUB_BUCKETS)
+            return b;
+        int e = (b - SUB_BUCKETS) / SUB_BUCKETS + 3, m = (b - SUB_BUCKETS) % SUB_BUCKETS;
+        return ((uint64_t)(SUB_BUCKETS + m + 1) << (e - 3)) - 1;
+    }
+    // Upper edge of the bucket holding the p-th sample
+    static uint64_t percentile(const vector<uint64_t> &hist, uint64_t total, double p)
+    {
+        uint64_t rank = max<uint64_t>(1, (uint64_t)ceil(p * total)), seen = 0;
+        for (int b = 0; b < BUCKETS; ++b)
+        {
+            seen += hist[b];
+            if (seen >= rank)
+                return upperBound(b);
+        }
+        return 0;
+    }
 };
-double dynamicPrice(const Flight &f)
-{
-    double occupancy = 1.0 - (double)f.seatsAvailable / f.seatsTotal;
-    return f.basePrice * (1 + occupancy * 0.5); // up to 50% more at full occupancy
-}
-// ---------------------- Airport Graph for Route Optimization ----------------------
-class AirportGraph
+
+#if FLIGHTEASE_METRICS
+struct ThreadMetrics
 {
-public:
-    unordered_map<string, vector<pair<string, int>>> adj;
-    unordered_map<string, vector<pair<string, double>>> adj_price;
+    atomic<uint64_t> calls[OP_COUNT];
+    atomic<uint64_t> totalNanos[OP_COUNT];
+    atomic<uint64_t> allocations[OP_COUNT];
+    atomic<uint64_t> buckets[OP_COUNT][LatencyHistogram::BUCKETS];
+
+    ThreadMetrics()
+    {
+        for (int op = 0; op < OP_COUNT; ++op)
+        {
+            calls[op].store(0, memory_order_relaxed);
+            totalNanos[op].store(0, memory_order_relaxed);
+            allocations[op].store(0, memory_order_relaxed);
+            for (int b = 0; b < LatencyHistogram::BUCKETS; ++b)
+                buckets[op][b].store(0, memory_order_relaxed);
+        }
+    }
 
-    void addFlight(const Flight &f)
+    // Only the owning thread writes, so a relaxed load + store is enough
+    static void bump(atomic<uint64_t> &counter, uint64_t by)
     {
-        int duration = f.arrivalTime - f.departureTime;
-        adj[f.source].push_back(make_pair(f.destination, duration));
-        adj_price[f.source].push_back(make_pair(f.destination, dynamicPrice(f)));
+        counter.store(counter.load(memory_order_relaxed) + by, memory_order_relaxed);
     }
+};
 
-    void removeFlight(const Flight &f)
+class MetricsRegistry
+{
+public:
+    static MetricsRegistry &instance()
     {
-        vector<pair<string, int>> &edges = adj[f.source];
-        edges.erase(remove_if(edges.begin(), edges.end(),
-                              [&](pair<string, int> &p)
-                              { return p.first == f.destination; }),
-                    edges.end());
+        static MetricsRegistry registry;
+        return registry;
     }
 
-    // Dijkstra's algorithm for shortest time
-    int shortestRoute(string src, string dest, vector<string> &path)
+    // Slabs outlive their threads so totals never go backwards
+    ThreadMetrics &local()
     {
-        unordered_map<string, int> dist;
-        unordered_map<string, string> prev;
-        for (unordered_map<string, vector<pair<string, int>>>::iterator it = adj.begin(); it != adj.end(); ++it)
+        static thread_local ThreadMetrics *mine = NULL;
+        if (!mine)
         {
-            dist[it->first] = numeric_limits<int>::max();
+            lock_guard<mutex> guard(lock);
+            slabs.push_back(unique_ptr<ThreadMetrics>(new ThreadMetrics()));
+            mine = slabs.back().get();
         }
-        dist[src] = 0;
+        return *mine;
+    }
 
-        typedef pair<int, string> PQElem;
-        priority_queue<PQElem, vector<PQElem>, greater<PQElem>> pq;
-        pq.push(make_pair(0, src));
+    void record(Operation op, uint64_t nanos, uint64_t allocations)
+    {
+        ThreadMetrics &m = local();
+        ThreadMetrics::bump(m.calls[op], 1);
+        ThreadMetrics::bump(m.totalNanos[op], nanos);
+        ThreadMetrics::bump(m.allocations[op], allocations);
+        ThreadMetrics::bump(m.buckets[op][LatencyHistogram::bucketOf(nanos)], 1);
+    }
 
-        while (!pq.empty())
+    void report(ostream &os)
+    {
+        lock_guard<mutex> guard(lock);
+        vector<uint64_t> merged(LatencyHistogram::BUCKETS);
+        ios::fmtflags flags = os.flags();
+        os << left << setw(24) << "Operation" << right << setw(10) << "Calls" << setw(12) << "Mean(us)"
+           << setw(12) << "p50(us)" << setw(12) << "p99(us)" << setw(12) << "p999(us)" << setw(12) << "Max(us)";
+#if FLIGHTEASE_ALLOC_COUNTERS
+        os << setw(13) << "Allocs/call";
+#endif
+        os << "\n";
+        os << fixed << setprecision(1);
+        for (int op = 0; op < OP_COUNT; ++op)
         {
-            PQElem top = pq.top();
-            pq.pop();
-            int curDist = top.first;
-            string u = top.second;
-            if (u == dest)
-                break;
-            vector<pair<string, int>> &neighbors = adj[u];
-            for (size_t i = 0; i < neighbors.size(); ++i)
+            uint64_t calls = 0, nanos = 0, allocations = 0;
+            fill(merged.begin(), merged.end(), 0);
+            for (size_t s = 0; s < slabs.size(); ++s)
             {
-                string v = neighbors[i].first;
-                int weight = neighbors[i].second;
-                if (curDist + weight < dist[v])
-                {
-                    dist[v] = curDist + weight;
-                    prev[v] = u;
-                    pq.push(make_pair(dist[v], v));
-                }
+                calls += slabs[s]->calls[op].load(memory_order_relaxed);
+                nanos += slabs[s]->totalNanos[op].load(memory_order_relaxed);
+                allocations += slabs[s]->allocations[op].load(memory_order_relaxed);
+                for (int b = 0; b < LatencyHistogram::BUCKETS; ++b)
+                    merged[b] += slabs[s]->buckets[op][b].load(memory_order_relaxed);
             }
+            if (calls == 0)
+                continue;
+            os << left << setw(24) << OPERATION_NAMES[op] << right << setw(10) << calls
+               << setw(12) << nanos / 1000.0 / calls
+               << setw(12) << LatencyHistogram::percentile(merged, calls, 0.50) / 1000.0
+               << setw(12) << LatencyHistogram::percentile(merged, calls, 0.99) / 1000.0
+               << setw(12) << LatencyHistogram::percentile(merged, calls, 0.999) / 1000.0
+               << setw(12) << LatencyHistogram::percentile(merged, calls, 1.0) / 1000.0;
+#if FLIGHTEASE_ALLOC_COUNTERS
+            os << setw(13) << (double)allocations / calls;
+#endif
+            os << "\n";
         }
-        if (dist[dest] == numeric_limits<int>::max())
-            return -1;
+        os.flags(flags);
+    }
 
-        // Build path
-        path.clear();
-        string cur = dest;
-        while (cur != src)
+private:
+    mutex lock;
+    vector<unique_ptr<ThreadMetrics>> slabs;
+};
+
+// Times one call; a timer built with on == false reads no clocks and records nothing
+class OperationTimer
+{
+public:
+    OperationTimer(Operation o, bool on) : op(o), active(on), allocationsBefore(0)
+    {
+        if (!active)
+            return;
+        allocationsBefore = heapAllocations();
+        start = chrono::steady_clock::now();
+    }
+    ~OperationTimer()
+    {
+        if (!active)
+            return;
+        uint64_t nanos = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+        MetricsRegistry::instance().record(op, nanos, heapAllocations() - allocationsBefore);
+    }
+
+private:
+    Operation op;
+    bool active;
+    uint64_t allocationsBefore;
+    chrono::steady_clock::time_point start;
+};
+
+// Rewrites `path` with the current report every `seconds`
+class MetricsDumper
+{
+public:
+    MetricsDumper(const string &p, int seconds) : path(p), interval(seconds), stopping(false)
+    {
+        worker = thread(&MetricsDumper::run, this);
+    }
+    ~MetricsDumper()
+    {
         {
-            path.push_back(cur);
-            cur = prev[cur];
+            lock_guard<mutex> guard(lock);
+            stopping = true;
         }
-        path.push_back(src);
-        reverse(path.begin(), path.end());
-        return dist[dest];
+        wake.notify_all();
+        worker.join();
+        dump(); // final snapshot on exit
     }
 
-    int cheapestRoute(string src, string dest, vector<string> &path)
+private:
+    string path;
+    int interval;
+    bool stopping;
+    mutex lock;
+    condition_variable wake;
+    thread worker;
+
+    void dump()
     {
-        unordered_map<string, int> dist;
-        unordered_map<string, string> prev;
+        ofstream out(path.c_str(), ios::trunc);
+        time_t now = time(NULL);
+        out << "FlightEase metrics at " << ctime(&now);
+        MetricsRegistry::instance().report(out);
+    }
 
-        for (const auto &entry : adj_price)
+    void run()
+    {
+        unique_lock<mutex> guard(lock);
+        while (!wake.wait_for(guard, chrono::seconds(interval), [this]
+                              { return stopping; }))
         {
-            dist[entry.first] = numeric_limits<int>::max();
+            guard.unlock();
+            dump();
+            guard.lock();
         }
-        dist[src] = 0;
-
-        typedef pair<int, string> PQElem;
-        priority_queue<PQElem, vector<PQElem>, greater<PQElem>> pq;
-        pq.push(make_pair(0, src));
+    }
+};
 
-        while (!pq.empty())
-        {
-            PQElem top = pq.top();
-            pq.pop();
+#define METRIC_CONCAT_(a, b) a##b
+#define METRIC_CONCAT(a, b) METRIC_CONCAT_(a, b)
+// For AirlinesSystem members: systems with recordMetrics off (benchmarks) stay out of the registry
+#define METRIC_SCOPE(op) OperationTimer METRIC_CONCAT(metricTimer_, __LINE__)(op, recordMetrics)
+#else
+#define METRIC_SCOPE(op) ((void)0)
+#endif
 
-            int curCost = top.first;
-            string u = top.second;
+// ---------------------- Trace Spans ----------------------
+// Scoped spans around internal phases (crew assignment, route search, report
+// generation), exported as Chrome trace-event JSON for chrome://tracing or
+// Perfetto. Each thread appends to its own fixed-size ring, publishing with a
+// single release store, so recording takes no locks; when a ring wraps, the
+// oldest spans are overwritten. Only the owner writes its ring: start() just
+// opens a new session, and each owner drops its older spans on its next
+// record. Every slot carries a sequence number, so the exporter skips a span
+// that is being overwritten as it reads. Spans cost one relaxed load while
+// no trace is being recorded. Build with -DFLIGHTEASE_TRACING=0 to compile
+// them out.
+#ifndef FLIGHTEASE_TRACING
+#define FLIGHTEASE_TRACING 1
+#endif
 
-            if (u == dest)
-                break;
+#if FLIGHTEASE_TRACING
+// Fields are relaxed atomics so the exporter may read a slot mid-write;
+// `sequence` tells it whether what it read is whole
+struct TraceEvent
+{
+    atomic<uint64_t> sequence{0}; // 2i+1 while event i is written, 2i+2 once it is complete
+    atomic<const char *> name{NULL};
+    atomic<uint64_t> startNanos{0};
+    atomic<uint64_t> durationNanos{0};
+    atomic<long long> arg{0};
+};
 
-            for (const auto &neighbor : adj_price[u])
-            {
-                string v = neighbor.first;
-                int cost = neighbor.second;
+struct TraceRing
+{
+    static constexpr size_t CAPACITY = 1 << 16;
+    int tid;
+    atomic<uint64_t> head;    // total events ever written by the owner
+    atomic<uint64_t> first;   // head when the owner joined `session`
+    atomic<uint64_t> session; // recording session the owner last wrote in
+    vector<TraceEvent> events;
+    TraceRing(int id) : tid(id), head(0), first(0), session(0), events(CAPACITY) {}
+};
 
-                if (curCost + cost < dist[v])
-                {
-                    dist[v] = curCost + cost;
-                    prev[v] = u;
-                    pq.push(make_pair(dist[v], v));
-                }
-            }
-        }
+class TraceRecorder
+{
+public:
+    static TraceRecorder &instance()
+    {
+        static TraceRecorder recorder;
+        return recorder;
+    }
 
-        if (dist[dest] == numeric_limits<int>::max())
-            return -1;
+    bool recording() const { return active.load(memory_order_relaxed); }
 
-        // Build path
-        path.clear();
-        string cur = dest;
-        while (cur != src)
-        {
-            path.push_back(cur);
-            cur = prev[cur];
-        }
-        path.push_back(src);
-        reverse(path.begin(), path.end());
+    uint64_t now() const
+    {
+        return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - epoch).count();
+    }
 
-        return dist[dest];
+    void start()
+    {
+        session.fetch_add(1, memory_order_release);
+        active.store(true, memory_order_release);
     }
-};
 
-// ---------------------- Main System Class ----------------------
-class AirlinesSystem
-{
-private:
-    vector<Flight> flights;
-    unordered_map<string, Passenger> passengers;
-    unordered_map<string, Admin> admins;
-    unordered_map<int, CrewMember> crew;
-    AirportGraph airportGraph;
-    int nextFlightID = 1000;
-    int nextCrewID = 1;
+    void stop() { active.store(false, memory_order_release); }
 
-    // --- Helper Functions ---
-    int binarySearchFlight(int flightID)
+    void record(const char *name, uint64_t start, uint64_t end, long long arg)
     {
-        int left = 0, right = flights.size() - 1;
-        while (left <= right)
+        if (!recording())
+            return; // the span outlived the recording
+        TraceRing &ring = local();
+        uint64_t h = ring.head.load(memory_order_relaxed);
+        uint64_t current = session.load(memory_order_acquire);
+        if (ring.session.load(memory_order_relaxed) != current)
         {
-            int mid = left + (right - left) / 2;
-            if (flights[mid].flightID == flightID)
-                return mid;
-            if (flights[mid].flightID < flightID)
-                left = mid + 1;
-            else
-                right = mid - 1;
+            ring.first.store(h, memory_order_relaxed);
+            ring.session.store(current, memory_order_release);
         }
-        return -1;
+        TraceEvent &e = ring.events[h & (TraceRing::CAPACITY - 1)];
+        e.sequence.store(2 * h + 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        e.name.store(name, memory_order_relaxed);
+        e.startNanos.store(start, memory_order_relaxed);
+        e.durationNanos.store(end - start, memory_order_relaxed);
+        e.arg.store(arg, memory_order_relaxed);
+        e.sequence.store(2 * h + 2, memory_order_release);
+        ring.head.store(h + 1, memory_order_release);
     }
 
-    int assignSeat(Flight &flight)
+    // Writes the buffered spans of every thread; returns how many were written
+    size_t exportJson(ostream &os)
     {
-        for (int i = 0; i < flight.seatsTotal; ++i)
+        lock_guard<mutex> guard(lock);
+        size_t written = 0;
+        uint64_t current = session.load(memory_order_acquire);
+        os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        for (size_t r = 0; r < rings.size(); ++r)
         {
-            if (!flight.seatMap[i])
+            TraceRing &ring = *rings[r];
+            if (ring.session.load(memory_order_acquire) != current)
+                continue; // nothing recorded by this thread since start()
+            uint64_t h = ring.head.load(memory_order_acquire);
+            uint64_t first = max(ring.first.load(memory_order_relaxed), h > TraceRing::CAPACITY ? h - TraceRing::CAPACITY : 0);
+            for (uint64_t i = first; i < h; ++i)
             {
-                flight.seatMap[i] = true;
-                flight.seatsAvailable--;
-                return i + 1;
+                const TraceEvent &e = ring.events[i & (TraceRing::CAPACITY - 1)];
+                uint64_t before = e.sequence.load(memory_order_acquire);
+                const char *name = e.name.load(memory_order_relaxed);
+                uint64_t start = e.startNanos.load(memory_order_relaxed);
+                uint64_t duration = e.durationNanos.load(memory_order_relaxed);
+                long long arg = e.arg.load(memory_order_relaxed);
+                atomic_thread_fence(memory_order_acquire);
+                if (before != 2 * i + 2 || e.sequence.load(memory_order_relaxed) != before)
+                    continue; // overwritten while we read it
+                os << (written++ ? ",\n" : "\n")
+                   << "{\"name\":\"" << name << "\",\"cat\":\"flightease\",\"ph\":\"X\",\"pid\":1,\"tid\":" << ring.tid
+                   << ",\"ts\":" << start / 1000.0 << ",\"dur\":" << duration / 1000.0;
+                if (arg >= 0)
+                    os << ",\"args\":{\"id\":" << arg << "}";
+                os << "}";
             }
         }
-        return -1;
+        os << "\n]}\n";
+        return written;
     }
 
-    bool isCrewAvailable(int crewID, int dep, int arr)
+private:
+    atomic<bool> active;
+    atomic<uint64_t> session; // bumped by every start()
+    chrono::steady_clock::time_point epoch;
+    mutex lock;
+    vector<unique_ptr<TraceRing>> rings;
+
+    TraceRecorder() : active(false), session(0), epoch(chrono::steady_clock::now()) {}
+
+    TraceRing &local()
     {
-        // Get the set of flights already assigned to this crew member
-        set<int> &assigned = crew[crewID].assignedFlights;
-        // Check for time conflicts with each assigned flight
-        for (set<int>::iterator it = assigned.begin(); it != assigned.end(); ++it)
+        static thread_local TraceRing *mine = NULL;
+        if (!mine)
         {
-            int fid = *it;
-            int idx = binarySearchFlight(fid);
-            if (idx == -1)
-                continue;
-            Flight &f = flights[idx];
-            // If times overlap, crew is not available for this flight
-            if (!(arr <= f.departureTime || dep >= f.arrivalTime))
-            {
-                return false;
-            }
+            lock_guard<mutex> guard(lock);
+            rings.push_back(unique_ptr<TraceRing>(new TraceRing(rings.size() + 1)));
+            mine = rings.back().get();
         }
-        // No conflicts found, crew is available
-        return true;
+        return *mine;
     }
+};
 
-    // Backtracking for crew assignment to a flight
-    bool assignCrewToFlight(int flightIdx, vector<int> &pilotIDs, vector<int> &attendantIDs)
+class TraceSpan
+{
+public:
+    TraceSpan(const char *n, long long a = -1) : name(n), arg(a), start(0)
     {
-        Flight &f = flights[flightIdx];
+        if (TraceRecorder::instance().recording())
+            start = TraceRecorder::instance().now() | 1; // never 0 while active
+    }
+    ~TraceSpan()
+    {
+        if (start)
+            TraceRecorder::instance().record(name, start, TraceRecorder::instance().now(), arg);
+    }
 
-        // Count already assigned pilots and attendants for this flight
-        int pilotCount = 0, attendantCount = 0;
-        for (int cid : f.crewAssigned)
-        {
-            if (crew[cid].role == "Pilot")
-                pilotCount++;
-            else if (crew[cid].role == "Attendant")
-                attendantCount++;
-        }
-        // If already enough crew assigned, skip assignment
-        if (pilotCount >= 2 && attendantCount >= 2)
-        {
-            cout << "Flight " << f.flightID << ": Already has 2 pilots and 2 attendants assigned. Skipping assignment.\n";
-            return false;
-        }
+private:
+    const char *name;
+    long long arg;
+    uint64_t start;
+};
 
-        // Find available pilots and attendants
-        vector<int> assignedPilots, assignedAttendants;
-        for (size_t i = 0; i < pilotIDs.size() && assignedPilots.size() < 2 - pilotCount; ++i)
-        {
-            int pid = pilotIDs[i];
-            if (isCrewAvailable(pid, f.departureTime, f.arrivalTime))
-                assignedPilots.push_back(pid);
-        }
-        for (size_t i = 0; i < attendantIDs.size() && assignedAttendants.size() < 2 - attendantCount; ++i)
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SPAN(...) TraceSpan TRACE_CONCAT(traceSpan_, __LINE__)(__VA_ARGS__)
+#else
+#define TRACE_SPAN(...) ((void)0)
+#endif
+
+// ---------------------- User Management ----------------------
+class User
+{
+public:
+    string username, password;
+    User(string u, string p) : username(u), password(p) {}
+    virtual ~User() {}
+};
+
+class Passenger : public User
+{
+public:
+    string name;
+    vector<int> bookings; // flightIDs
+    Passenger() : User("test", "test"), name("test") {}
+    Passenger(string u, string p, string n) : User(u, p), name(n) {}
+};
+
+class Admin : public User
+{
+public:
+    Admin() : User("test", "test") {}
+    Admin(string u, string p) : User(u, p) {}
+};
+
+// ---------------------- Crew Management ----------------------
+enum CrewRole
+{
+    ROLE_PILOT,
+    ROLE_CO_PILOT,
+    ROLE_ATTENDANT,
+    ROLE_UNKNOWN
+};
+
+// Role sets for eligibility filters, one bit per CrewRole
+const uint32_t FLIGHT_DECK_ROLES = (1u << ROLE_PILOT) | (1u << ROLE_CO_PILOT);
+const uint32_t CABIN_ROLES = 1u << ROLE_ATTENDANT;
+
+const char *crewRoleName(CrewRole role)
+{
+    const char *names[] = {"Pilot", "Co-Pilot", "Attendant", "Unknown"};
+    return names[role];
+}
+
+// Accepts the usual spellings: "pilot", "Co-Pilot", "copilot", "attendant"...
+CrewRole parseCrewRole(const string &text)
+{
+    string key;
+    for (size_t i = 0; i < text.size(); ++i)
+        if (isalpha((unsigned char)text[i]))
+            key += tolower((unsigned char)text[i]);
+    if (key == "pilot" || key == "captain")
+        return ROLE_PILOT;
+    if (key == "copilot" || key == "firstofficer")
+        return ROLE_CO_PILOT;
+    if (key == "attendant" || key == "flightattendant" || key == "cabincrew")
+        return ROLE_ATTENDANT;
+    return ROLE_UNKNOWN;
+}
+
+struct CrewMember
+{
+    int id;
+    string name;
+    CrewRole role;
+    uint64_t qualifications; // one bit per registered qualification
+    set<int> assignedFlights;
+    CrewMember() : id(0), name(""), role(ROLE_UNKNOWN), qualifications(0) {}
+    CrewMember(int i, string n, CrewRole r) : id(i), name(n), role(r), qualifications(0) {}
+};
+
+// Packed copy of every crew member's role and qualifications, in ID order.
+// Eligibility for a flight is one AND-and-compare per member with no
+// branches, so filtering thousands of crew stays within a few cache lines.
+class CrewRoster
+{
+public:
+    void add(int id, CrewRole role, uint64_t qualifications)
+    {
+        slot[id] = ids.size();
+        ids.push_back(id);
+        roleBits.push_back(1u << role);
+        quals.push_back(qualifications);
+    }
+
+    void setQualifications(int id, uint64_t qualifications)
+    {
+        quals[slot[id]] = qualifications;
+    }
+
+    size_t size() const { return ids.size(); }
+
+    // IDs of members holding one of `roles` and every bit of `required`.
+    // Each ID is written unconditionally and the cursor only advances on a
+    // match, which keeps the loop free of data-dependent branches.
+    void filter(uint32_t roles, uint64_t required, vector<int> &out) const
+    {
+        out.resize(ids.size());
+        size_t n = 0;
+        for (size_t i = 0; i < ids.size(); ++i)
         {
-            int aid = attendantIDs[i];
-            if (isCrewAvailable(aid, f.departureTime, f.arrivalTime))
-                assignedAttendants.push_back(aid);
+            out[n] = ids[i];
+            n += ((quals[i] & required) == required) & ((roleBits[i] & roles) != 0);
         }
+        out.resize(n);
+    }
 
-        int totalPilots = pilotCount + assignedPilots.size();
-        int totalAttendants = attendantCount + assignedAttendants.size();
+    size_t count(uint32_t roles) const
+    {
+        size_t n = 0;
+        for (size_t i = 0; i < roleBits.size(); ++i)
+            n += (roleBits[i] & roles) != 0;
+        return n;
+    }
 
-        if (totalPilots == 2 && totalAttendants == 2)
+private:
+    vector<int> ids;
+    vector<uint32_t> roleBits;
+    vector<uint64_t> quals;
+    unordered_map<int, size_t> slot;
+};
+
+// ---------------------- Flight and Booking ----------------------
+// A seat taken out of the allocator while the passenger pays; it becomes a
+// Booking on confirm, or goes back (and to the waitlist) on release or expiry.
+struct SeatHold
+{
+    string username;
+    int flightID;
+    int seatNo;
+    int timer;          // TimingWheel handle
+    uint64_t expiresAt; // ms on the hold clock
+};
+
+struct Booking
+{
+    string passengerUsername;
+    int seatNo;
+    bool active;
+    Booking(string u, int s) : passengerUsername(u), seatNo(s), active(true) {}
+};
+
+// A waitlisted party is seated together or not at all
+struct WaitlistEntry
+{
+    string username;
+    int partySize;
+    WaitlistEntry(string u, int n = 1) : username(u), partySize(n) {}
+};
+
+struct Flight
+{
+    int flightID;
+    string source;
+    string destination;
+    int departureTime; // minutes from midnight
+    int arrivalTime;
+    int seatsTotal;
+    int seatsAvailable;
+    vector<bool> seatMap;
+    vector<Booking> bookings;
+    queue<WaitlistEntry> waitlist;
+    int waitlistedPassengers = 0;
+    double basePrice;
+    vector<int> crewAssigned; // crew IDs
+    shared_ptr<mutex> seatLock; // held while an itinerary booking touches the seats
+    uint64_t crewRequirements = 0; // qualifications every assigned crew member must hold
+    vector<uint64_t> holdExpiries; // when each seat hold on this flight lapses, ascending
+
+    Flight(int id, string src, string dest, int dep, int arr, int seats, double price)
+        : flightID(id), source(src), destination(dest), departureTime(dep),
+          arrivalTime(arr), seatsTotal(seats), seatsAvailable(seats),
+          seatMap(seats, false), basePrice(price), seatLock(make_shared<mutex>()) {}
+};
+const int MIN_CONNECTION_MINUTES = 45; // shortest transfer a passenger can be expected to make
+
+double dynamicPrice(double basePrice, int seatsTotal, int seatsAvailable)
+{
+    double occupancy = 1.0 - (double)seatsAvailable / seatsTotal;
+    return basePrice * (1 + occupancy * 0.5); // up to 50% more at full occupancy
+}
+
+double dynamicPrice(const Flight &f)
+{
+    return dynamicPrice(f.basePrice, f.seatsTotal, f.seatsAvailable);
+}
+
+int fareInCents(double price) { return (int)llround(price * 100); }
+// ---------------------- Airport Graph for Route Optimization ----------------------
+enum RouteSearchMode
+{
+    SEARCH_DIJKSTRA,      // one-sided search from the source
+    SEARCH_BIDIRECTIONAL, // forward and backward searches meeting in the middle
+    SEARCH_ASTAR          // goal-directed by a great-circle lower bound (durations only)
+};
+
+struct RouteSearchStats
+{
+    int nodesSettled;
+    int edgesRelaxed;
+    RouteSearchStats() : nodesSettled(0), edgesRelaxed(0) {}
+};
+
+struct RouteQuery
+{
+    string src, dest;
+    bool byPrice; // cheapest instead of shortest
+    RouteQuery(string s, string d, bool price = false) : src(s), dest(d), byPrice(price) {}
+};
+
+struct RouteResult
+{
+    int cost; // minutes or INR, -1 when there is no route
+    vector<string> path;
+    vector<int> flights; // flight ID of each leg
+    RouteResult() : cost(-1) {}
+};
+
+// One airport of a reachability query. Results form a tree: follow `parent`
+// (an index into the same result list) back to the origin for the path.
+struct ReachableAirport
+{
+    string code;
+    int cost;
+    int parent; // -1 for the origin itself
+};
+
+struct Arc
+{
+    int to;
+    int weight;
+    int flightID; // -1 for synthetic edges
+    Arc(int t, int w, int id = -1) : to(t), weight(w), flightID(id) {}
+};
+
+const int INF_COST = numeric_limits<int>::max();
+
+// Per-thread search state. Entries are invalidated by bumping `stamp`, so a
+// query only pays for the airports it actually visits.
+struct SearchScratch
+{
+    vector<int> dist;
+    vector<int> prev;
+    vector<int> bound; // A* lower bound to the target, cached on first visit
+    vector<unsigned> seen;
+    vector<unsigned> target; // airports a one-to-many search still has to settle
+    vector<pair<int, int>> heap;
+    unsigned stamp;
+
+    SearchScratch() : stamp(0) {}
+
+    void reset(size_t n)
+    {
+        if (seen.size() < n)
         {
-            // Assign crew
-            for (int pid : assignedPilots)
-            {
-                f.crewAssigned.push_back(pid);
-                crew[pid].assignedFlights.insert(flightID);
-            }
-            for (int aid : assignedAttendants)
-            {
-                f.crewAssigned.push_back(aid);
-                crew[aid].assignedFlights.insert(flightID);
-            }
-            // cout << "Flight " << f.flightID << ": Crew assigned";
-            // cout << "  Pilots: ";
-            // for (int cid : f.crewAssigned) if (crew[cid].role == "Pilot") cout << cid << " ";
-            // cout << "\n  Attendants: ";
-            // for (int cid : f.crewAssigned) if (crew[cid].role == "Attendant") cout << cid << " ";
-            // cout << "\n";
-            return true;
+            dist.resize(n);
+            prev.resize(n);
+            bound.resize(n);
+            seen.resize(n, 0);
+            target.resize(n, 0);
         }
-        else
+        heap.clear();
+        if (++stamp == 0)
         {
-            int neededPilots = 2 - totalPilots;
-            int neededAttendants = 2 - totalAttendants;
-            cout << "Flight " << f.flightID << ": Could not assign required crew. Needed ";
-            return false;
+            fill(seen.begin(), seen.end(), 0);
+            fill(target.begin(), target.end(), 0);
+            stamp = 1;
         }
     }
+    bool visited(int v) const { return seen[v] == stamp; }
+    int get(int v) const { return visited(v) ? dist[v] : INF_COST; }
+    void push(int key, int v)
+    {
+        heap.push_back(make_pair(key, v));
+        push_heap(heap.begin(), heap.end(), greater<pair<int, int>>());
+    }
+    pair<int, int> pop()
+    {
+        pop_heap(heap.begin(), heap.end(), greater<pair<int, int>>());
+        pair<int, int> top = heap.back();
+        heap.pop_back();
+        return top;
+    }
+};
 
+class AirportGraph
+{
 public:
-    AirlinesSystem()
+    unordered_map<string, int> airportIndex; // airport code -> interned id
+    vector<string> airportCodes;
+    vector<double> latitude, longitude;
+    vector<bool> hasLocation;
+    int locatedAirports = 0;
+
+    // Searches see one arc per airport pair: the fastest (adj) and the
+    // cheapest (adj_price) of its parallel flights. adj[u][k] and
+    // adj_price[u][k] always describe the same pair, as do the radj lists.
+    vector<vector<Arc>> adj, radj;             // duration in minutes
+    vector<vector<Arc>> adj_price, radj_price; // price in INR
+
+    // Fastest observed ground speed (km/min) over any edge between located
+    // airports; dividing great-circle distance by it never overestimates.
+    double maxSpeed = 0;
+    bool instantEdge = false; // a non-positive duration makes the bound useless
+    long long version = 0;    // bumped on every change to the flight edges
+
+    int internAirport(const string &code)
     {
-        // Add a default admin
-        admins["admin"] = Admin("admin", "admin123");
-        // Add some crew
-        crew[nextCrewID] = CrewMember(nextCrewID, "John Pilot", "Pilot");
-        nextCrewID++;
-        crew[nextCrewID] = CrewMember(nextCrewID, "Jane CoPilot", "Pilot");
-        nextCrewID++;
-        crew[nextCrewID] = CrewMember(nextCrewID, "Alice Attendant", "Attendant");
-        nextCrewID++;
-        crew[nextCrewID] = CrewMember(nextCrewID, "Bob Attendant", "Attendant");
-        nextCrewID++;
-        crew[nextCrewID] = CrewMember(nextCrewID, "Divyansh", "Pilot");
-        nextCrewID++;
-        crew[nextCrewID] = CrewMember(nextCrewID, "Somu", "Pilot");
-        nextCrewID++;
-        crew[nextCrewID] = CrewMember(nextCrewID, "Aditya", "Attendant");
-        nextCrewID++;
-        crew[nextCrewID] = CrewMember(nextCrewID, "Arman", "Attendant");
-        nextCrewID++;
-        crew[nextCrewID] = CrewMember(nextCrewID, "Tanya", "Attendant");
-        nextCrewID++;
+        unordered_map<string, int>::iterator it = airportIndex.find(code);
+        if (it != airportIndex.end())
+            return it->second;
+        int id = airportCodes.size();
+        airportIndex[code] = id;
+        airportCodes.push_back(code);
+        latitude.push_back(0);
+        longitude.push_back(0);
+        hasLocation.push_back(false);
+        adj.push_back(vector<Arc>());
+        radj.push_back(vector<Arc>());
+        adj_price.push_back(vector<Arc>());
+        radj_price.push_back(vector<Arc>());
+        return id;
     }
 
-    // --- User Authentication ---
-    bool registerPassenger(string username, string password, string name)
+    int findAirport(const string &code) const
     {
-        if (passengers.count(username) || admins.count(username))
-            return false;
-        passengers[username] = Passenger(username, password, name);
-        return true;
+        unordered_map<string, int>::const_iterator it = airportIndex.find(code);
+        return it == airportIndex.end() ? -1 : it->second;
     }
 
-    Passenger *loginPassenger(string username, string password)
+    void setAirportLocation(const string &code, double lat, double lon)
     {
-        if (passengers.count(username) && passengers[username].password == password)
-            return &passengers[username];
-        return NULL;
+        int id = internAirport(code);
+        if (!hasLocation[id])
+            locatedAirports++;
+        latitude[id] = lat;
+        longitude[id] = lon;
+        hasLocation[id] = true;
+        // Edges added before the airport was located still have to respect the bound
+        for (size_t i = 0; i < adj[id].size(); ++i)
+            noteEdgeSpeed(id, adj[id][i].to, adj[id][i].weight);
+        for (size_t i = 0; i < radj[id].size(); ++i)
+            noteEdgeSpeed(radj[id][i].to, id, radj[id][i].weight);
     }
 
-    Admin *loginAdmin(string username, string password)
+    double greatCircleKm(int a, int b) const
     {
-        if (admins.count(username) && admins[username].password == password)
-            return &admins[username];
-        return NULL;
+        const double R = 6371.0, RAD = 3.14159265358979323846 / 180.0;
+        double dLat = (latitude[b] - latitude[a]) * RAD;
+        double dLon = (longitude[b] - longitude[a]) * RAD;
+        double h = sin(dLat / 2) * sin(dLat / 2) +
+                   cos(latitude[a] * RAD) * cos(latitude[b] * RAD) * sin(dLon / 2) * sin(dLon / 2);
+        return 2 * R * asin(min(1.0, sqrt(h)));
     }
 
-    // --- Flight Management (Admin) ---
-    void addFlight(string src, string dest, int dep, int arr, int seats, double price)
+    // A* is only sound when every airport has coordinates; otherwise it degrades to Dijkstra
+    bool hasDistanceBound() const
     {
-        Flight f(nextFlightID++, src, dest, dep, arr, seats, price);
-        flights.push_back(f);
-        sort(flights.begin(), flights.end(), [](const Flight &a, const Flight &b)
-             { return a.flightID < b.flightID; });
-        airportGraph.addFlight(flights.back());
-        cout << "Flight added: ID " << flights.back().flightID << endl;
+        return locatedAirports == (int)airportCodes.size() && maxSpeed > 0 && !instantEdge;
     }
 
-    void removeFlight(int flightID)
+    // Adds the flight's edge and returns its handle; a flight already in
+    // the graph is updated instead
+    int addFlight(const Flight &f)
     {
-        int idx = binarySearchFlight(flightID);
-        if (idx == -1)
+        unordered_map<int, int>::iterator known = edgeOfFlight.find(f.flightID);
+        if (known != edgeOfFlight.end())
         {
-            cout << "Flight not found.\n";
-            return;
+            updateFlight(f);
+            return edgeOfFlight[f.flightID];
         }
-        airportGraph.removeFlight(flights[idx]);
-        flights.erase(flights.begin() + idx);
-        cout << "Flight removed.\n";
+        int u = internAirport(f.source);
+        int v = internAirport(f.destination);
+        int p = pairOf(u, v);
+        int e;
+        if (freeEdges.empty())
+        {
+            e = edges.size();
+            edges.push_back(FlightEdge());
+        }
+        else
+        {
+            e = freeEdges.back();
+            freeEdges.pop_back();
+        }
+        FlightEdge &edge = edges[e];
+        edge.flightID = f.flightID;
+        edge.pair = p;
+        edge.duration = f.arrivalTime - f.departureTime;
+        edge.price = (int)dynamicPrice(f);
+        edge.posInPair = pairs[p].edges.size();
+        pairs[p].edges.push_back(e);
+        edgeOfFlight[f.flightID] = e;
+        offer(p, e);
+        noteEdgeSpeed(u, v, edge.duration);
+        version++;
+        return e;
     }
 
-    void updateFlight(int flightID, int dep, int arr, int seats, double price)
+    // New times or fare for a flight already in the graph
+    void updateFlight(const Flight &f)
     {
-        int idx = binarySearchFlight(flightID);
-        if (idx == -1)
+        unordered_map<int, int>::iterator it = edgeOfFlight.find(f.flightID);
+        if (it == edgeOfFlight.end())
         {
-            cout << "Flight not found.\n";
+            addFlight(f);
             return;
         }
-        flights[idx].departureTime = dep;
-        flights[idx].arrivalTime = arr;
-        flights[idx].seatsTotal = seats;
-        flights[idx].seatsAvailable = seats;
-        flights[idx].basePrice = price;
-        flights[idx].seatMap = vector<bool>(seats, false);
-        cout << "Flight updated.\n";
+        int e = it->second;
+        RoutePair &r = pairs[edges[e].pair];
+        if (airportCodes[r.from] != f.source || airportCodes[r.to] != f.destination)
+        {
+            removeFlight(f);
+            addFlight(f);
+            return;
+        }
+        int oldDuration = edges[e].duration, oldPrice = edges[e].price;
+        edges[e].duration = f.arrivalTime - f.departureTime;
+        edges[e].price = (int)dynamicPrice(f);
+        // Only a best edge getting worse needs a look at its parallel flights
+        if ((r.fastest == e && edges[e].duration > oldDuration) || (r.cheapest == e && edges[e].price > oldPrice))
+            rescan(edges[e].pair);
+        else
+            offer(edges[e].pair, e);
+        noteEdgeSpeed(r.from, r.to, edges[e].duration);
+        version++;
     }
 
-    void listFlights()
+    // Removes only this flight; parallel flights on the route keep their edges
+    void removeFlight(const Flight &f)
     {
-
-        cout << "Available Flights:\n";
-        for (size_t i = 0; i < flights.size(); ++i)
-        {
-            const Flight &f = flights[i];
-            cout << "ID: " << f.flightID << " | " << f.source << "->" << f.destination
-                 << " | Dep: " << minutesToTime(f.departureTime)
-                 << " | Arr: " << minutesToTime(f.arrivalTime)
-                 << " | Seats: " << f.seatsAvailable << "/" << f.seatsTotal
-                 << " | Price: " << dynamicPrice(f) << endl;
-        }
+        unordered_map<int, int>::iterator it = edgeOfFlight.find(f.flightID);
+        if (it == edgeOfFlight.end())
+            return;
+        int e = it->second;
+        edgeOfFlight.erase(it);
+        int p = edges[e].pair;
+        RoutePair &r = pairs[p];
+        int last = r.edges.back();
+        r.edges[edges[e].posInPair] = last;
+        edges[last].posInPair = edges[e].posInPair;
+        r.edges.pop_back();
+        edges[e].pair = -1;
+        freeEdges.push_back(e);
+        if (r.edges.empty())
+            dropPair(p);
+        else if (r.fastest == e || r.cheapest == e)
+            rescan(p);
+        version++;
     }
 
-    // --- Crew Management (Admin) ---
-    void addCrew(string name, string role)
+    // Shortest travel time; returns -1 when dest is unreachable
+    int shortestRoute(const string &src, const string &dest, vector<string> &path,
+                      RouteSearchMode mode = SEARCH_DIJKSTRA, RouteSearchStats *stats = NULL) const
     {
-        crew[nextCrewID] = CrewMember(nextCrewID, name, role);
-        cout << "Crew added: ID " << nextCrewID << ", " << name << ", " << role << endl;
-        nextCrewID++;
+        return route(adj, radj, src, dest, path, mode, mode == SEARCH_ASTAR && hasDistanceBound(), stats);
     }
 
-    void assignCrewToAllFlights()
+    // Lowest total fare; A* has no admissible bound for prices and runs as plain Dijkstra
+    int cheapestRoute(const string &src, const string &dest, vector<string> &path,
+                      RouteSearchMode mode = SEARCH_DIJKSTRA, RouteSearchStats *stats = NULL) const
     {
-        vector<int> pilotIDs, attendantIDs;
-        for (unordered_map<int, CrewMember>::iterator it = crew.begin(); it != crew.end(); ++it)
-        {
-            int id = it->first;
-            CrewMember &c = it->second;
-            if (c.role == "Pilot")
-                pilotIDs.push_back(id);
-            else if (c.role == "Attendant")
-                attendantIDs.push_back(id);
-        }
-        for (size_t i = 0; i < flights.size(); ++i)
-        {
-            if (assignCrewToFlight(i, pilotIDs, attendantIDs))
-                cout << "Crew assigned to flight " << flights[i].flightID << endl;
-            else
-                cout << "Could not assign crew to flight " << flights[i].flightID << endl;
-        }
+        return route(adj_price, radj_price, src, dest, path, mode, false, stats);
     }
 
-    void listCrew()
+    // Concrete flight for each leg of a path: the fastest (or cheapest) of the
+    // parallel flights on that hop, i.e. the edge every search relaxed.
+    // Returns false if some hop has no flight any more.
+    bool legFlights(const vector<string> &path, bool byPrice, vector<int> &legs) const
     {
-        for (unordered_map<int, CrewMember>::iterator it = crew.begin(); it != crew.end(); ++it)
+        legs.clear();
+        for (size_t i = 0; i + 1 < path.size(); ++i)
         {
-            int id = it->first;
-            CrewMember &c = it->second;
-            cout << "ID: " << id << ", Name: " << c.name << ", Role: " << c.role << endl;
+            int u = findAirport(path[i]), v = findAirport(path[i + 1]);
+            if (u == -1 || v == -1)
+                return false;
+            unordered_map<long long, int>::const_iterator it = pairIndex.find(pairKey(u, v));
+            if (it == pairIndex.end())
+                return false;
+            const RoutePair &r = pairs[it->second];
+            legs.push_back(edges[byPrice ? r.cheapest : r.fastest].flightID);
         }
+        return true;
     }
-    pair<int, int> minCrewRequired(vector<Flight> &flights)
-    {
-        sort(flights.begin(), flights.end(), [](const Flight &a, const Flight &b)
-             { return a.departureTime < b.departureTime; });
 
-        priority_queue<int, vector<int>, greater<int>> pilotAvailable;
-        priority_queue<int, vector<int>, greater<int>> attendantAvailable;
-
-        int totalPilots = 0;
-        int totalAttendants = 0;
+    // One search from src that stops once every destination is settled, so a
+    // group of queries sharing a source costs a single Dijkstra. Safe to call
+    // concurrently as long as nobody modifies the graph.
+    void routesFrom(const string &src, const vector<string> &dests, bool byPrice,
+                    vector<RouteResult> &results, RouteSearchStats *stats = NULL) const
+    {
+        RouteSearchStats local;
+        if (!stats)
+            stats = &local;
+        *stats = RouteSearchStats();
+        results.assign(dests.size(), RouteResult());
+        int s = findAirport(src);
+        const vector<vector<Arc>> &graph = byPrice ? adj_price : adj;
 
-        for (const Flight &f : flights)
+        TRACE_SPAN("oneToManySearch");
+        static thread_local SearchScratch sc;
+        sc.reset(airportCodes.size());
+        int remaining = 0;
+        for (size_t i = 0; i < dests.size(); ++i)
         {
-            int pilotsAssigned = 0;
-            int attendantsAssigned = 0;
-
-            while (!pilotAvailable.empty() && pilotAvailable.top() <= f.departureTime && pilotsAssigned < 2)
+            int t = findAirport(dests[i]);
+            if (t != -1 && t != s && sc.target[t] != sc.stamp)
             {
-                pilotAvailable.pop();
-                pilotsAssigned++;
+                sc.target[t] = sc.stamp;
+                remaining++;
             }
-            totalPilots += (2 - pilotsAssigned);
+        }
 
-            while (!attendantAvailable.empty() && attendantAvailable.top() <= f.departureTime && attendantsAssigned < 2)
-            {
-                attendantAvailable.pop();
-                attendantsAssigned++;
+        if (s != -1)
+        {
+            sc.seen[s] = sc.stamp;
+            sc.dist[s] = 0;
+            sc.prev[s] = -1;
+            sc.push(0, s);
+        }
+        while (remaining > 0 && !sc.heap.empty())
+        {
+            pair<int, int> top = sc.pop();
+            int u = top.second, d = top.first;
+            if (d > sc.dist[u])
+                continue;
+            stats->nodesSettled++;
+            if (sc.target[u] == sc.stamp)
+                remaining--;
+            for (size_t i = 0; i < graph[u].size(); ++i)
+            {
+                int v = graph[u][i].to;
+                int nd = d + graph[u][i].weight;
+                stats->edgesRelaxed++;
+                if (nd < sc.get(v))
+                {
+                    sc.seen[v] = sc.stamp;
+                    sc.dist[v] = nd;
+                    sc.prev[v] = u;
+                    sc.push(nd, v);
+                }
             }
-            totalAttendants += (2 - attendantsAssigned);
+        }
 
-            for (int i = 0; i < 2; ++i)
+        for (size_t i = 0; i < dests.size(); ++i)
+        {
+            RouteResult &r = results[i];
+            if (dests[i] == src)
             {
-                pilotAvailable.push(f.arrivalTime);
-                attendantAvailable.push(f.arrivalTime);
+                r.cost = 0;
+                r.path.push_back(src);
+                continue;
             }
+            int t = findAirport(dests[i]);
+            if (s == -1 || t == -1 || sc.get(t) == INF_COST)
+                continue;
+            r.cost = sc.dist[t];
+            for (int cur = t; cur != -1; cur = sc.prev[cur])
+                r.path.push_back(airportCodes[cur]);
+            reverse(r.path.begin(), r.path.end());
+            legFlights(r.path, byPrice, r.flights);
         }
-
-        return {totalPilots, totalAttendants};
     }
-    void checkCrewVacancy()
+
+    // Every airport reachable from src within `limit` minutes (or INR), in
+    // order of cost. Edges that would cross the limit are never queued, so the
+    // search ends at the edge of the isochrone; `out` and the scratch buffers
+    // keep their capacity between calls.
+    void reachableWithin(const string &src, int limit, bool byPrice, vector<ReachableAirport> &out) const
     {
-        int currentPilotsAvailable = 0;
-        int currentAttendantsAvailable = 0;
+        out.clear();
+        int s = findAirport(src);
+        if (s == -1 || limit < 0)
+            return;
+        const vector<vector<Arc>> &graph = byPrice ? adj_price : adj;
 
-        for (auto it = crew.begin(); it != crew.end(); ++it)
+        TRACE_SPAN("reachableSearch");
+        static thread_local SearchScratch sc;
+        sc.reset(airportCodes.size());
+        sc.seen[s] = sc.stamp;
+        sc.dist[s] = 0;
+        sc.prev[s] = -1;
+        sc.push(0, s);
+        while (!sc.heap.empty())
         {
-            CrewMember &c = it->second;
-            if (c.role == "Pilot")
-                currentPilotsAvailable++;
-            else if (c.role == "Attendant")
-                currentAttendantsAvailable++;
+            pair<int, int> top = sc.pop();
+            int u = top.second, d = top.first;
+            if (d > sc.dist[u])
+                continue;
+            // prev[] holds result indices here, which become the parent links
+            int self = out.size();
+            ReachableAirport r = {airportCodes[u], d, sc.prev[u]};
+            out.push_back(r);
+            for (size_t i = 0; i < graph[u].size(); ++i)
+            {
+                int v = graph[u][i].to;
+                int nd = d + graph[u][i].weight;
+                if (nd <= limit && nd < sc.get(v))
+                {
+                    sc.seen[v] = sc.stamp;
+                    sc.dist[v] = nd;
+                    sc.prev[v] = self;
+                    sc.push(nd, v);
+                }
+            }
         }
+    }
 
-        pair<int, int> required = minCrewRequired(flights);
+private:
+    // One edge per flight, addressed by its handle; removed slots are reused
+    struct FlightEdge
+    {
+        int flightID;
+        int pair; // RoutePair slot, -1 while free
+        int duration, price;
+        int posInPair; // index in the pair's edge list
+    };
 
-        int extraPilots = max(0, required.first - currentPilotsAvailable);
-        int extraAttendants = max(0, required.second - currentAttendantsAvailable);
+    // The parallel flights u -> v and where their summary arcs live:
+    // adj[from][fwdPos], adj_price[from][fwdPos] and the same in radj[to]
+    struct RoutePair
+    {
+        int from, to;
+        vector<int> edges;
+        int fwdPos, bwdPos;
+        int fastest, cheapest; // edge handles
+    };
 
-        cout << "Add " << extraPilots << " more pilots" << endl;
-        cout << "Add " << extraAttendants << " more attendants" << endl;
-    }
+    vector<FlightEdge> edges;
+    vector<int> freeEdges;
+    unordered_map<int, int> edgeOfFlight; // flight ID -> edge handle
+    vector<RoutePair> pairs;
+    vector<int> freePairs;
+    unordered_map<long long, int> pairIndex;
 
-    void searchFlights(string src, string dest)
+    static long long pairKey(int u, int v) { return ((long long)u << 32) | (unsigned)v; }
+
+    int pairOf(int u, int v)
     {
-        if (src.empty() || dest.empty())
+        unordered_map<long long, int>::iterator it = pairIndex.find(pairKey(u, v));
+        if (it != pairIndex.end())
+            return it->second;
+        int p;
+        if (freePairs.empty())
         {
-            cout << "Error: Source or destination cannot be empty.\n";
-            return;
+            p = pairs.size();
+            pairs.push_back(RoutePair());
         }
-
-        if (flights.empty())
+        else
         {
-            cout << "Error: No flights available.\n";
-            return;
+            p = freePairs.back();
+            freePairs.pop_back();
         }
+        RoutePair &r = pairs[p];
+        r.from = u;
+        r.to = v;
+        r.edges.clear();
+        r.fastest = r.cheapest = -1;
+        r.fwdPos = adj[u].size();
+        r.bwdPos = radj[v].size();
+        adj[u].push_back(Arc(v, 0));
+        adj_price[u].push_back(Arc(v, 0));
+        radj[v].push_back(Arc(u, 0));
+        radj_price[v].push_back(Arc(u, 0));
+        pairIndex[pairKey(u, v)] = p;
+        return p;
+    }
 
-        cout << "Flights from " << src << " to " << dest << ":\n";
-
-        bool found = false;
-        for (size_t i = 0; i < flights.size(); ++i)
+    // Last pair of the route gone: swap its arcs out of the four lists and
+    // repoint the pairs whose arcs moved into the gap
+    void dropPair(int p)
+    {
+        RoutePair &r = pairs[p];
+        int u = r.from, v = r.to;
+        if (r.fwdPos + 1 < (int)adj[u].size())
         {
-            const Flight &f = flights[i];
-
-            if (f.source == src && f.destination == dest)
-            {
-                found = true;
-                cout << "ID: " << f.flightID << " | Dep: " << minutesToTime(f.departureTime)
-                     << " | Arr: " << minutesToTime(f.arrivalTime)
-                     << " | Seats: " << f.seatsAvailable << "/" << f.seatsTotal
-                     << " | Price: " << dynamicPrice(f) << endl;
-            }
+            adj[u][r.fwdPos] = adj[u].back();
+            adj_price[u][r.fwdPos] = adj_price[u].back();
+            pairs[pairIndex[pairKey(u, adj[u][r.fwdPos].to)]].fwdPos = r.fwdPos;
         }
-
-        if (!found)
+        adj[u].pop_back();
+        adj_price[u].pop_back();
+        if (r.bwdPos + 1 < (int)radj[v].size())
         {
-            cout << "Error: No flights found from " << src << " to " << dest << ".\n";
+            radj[v][r.bwdPos] = radj[v].back();
+            radj_price[v][r.bwdPos] = radj_price[v].back();
+            pairs[pairIndex[pairKey(radj[v][r.bwdPos].to, v)]].bwdPos = r.bwdPos;
         }
+        radj[v].pop_back();
+        radj_price[v].pop_back();
+        pairIndex.erase(pairKey(u, v));
+        freePairs.push_back(p);
     }
 
-    void searchFlightsByTime(int earliestDep, int latestDep)
+    // Takes edge e as the pair's best where it beats the current one
+    void offer(int p, int e)
     {
-        if (earliestDep > latestDep)
+        RoutePair &r = pairs[p];
+        if (r.fastest == -1 || edges[e].duration < edges[r.fastest].duration)
+            r.fastest = e;
+        if (r.cheapest == -1 || edges[e].price < edges[r.cheapest].price)
+            r.cheapest = e;
+        publish(p);
+    }
+
+    // Recomputes both bests from the pair's parallel flights
+    void rescan(int p)
+    {
+        RoutePair &r = pairs[p];
+        r.fastest = r.cheapest = -1;
+        for (size_t i = 0; i < r.edges.size(); ++i)
         {
-            cout << "Error: Earliest departure time cannot be later than latest departure time.\n";
-            return;
+            int e = r.edges[i];
+            if (r.fastest == -1 || edges[e].duration < edges[r.fastest].duration)
+                r.fastest = e;
+            if (r.cheapest == -1 || edges[e].price < edges[r.cheapest].price)
+                r.cheapest = e;
         }
+        publish(p);
+    }
+
+    void publish(int p)
+    {
+        const RoutePair &r = pairs[p];
+        const FlightEdge &fast = edges[r.fastest], &cheap = edges[r.cheapest];
+        adj[r.from][r.fwdPos] = Arc(r.to, fast.duration, fast.flightID);
+        radj[r.to][r.bwdPos] = Arc(r.from, fast.duration, fast.flightID);
+        adj_price[r.from][r.fwdPos] = Arc(r.to, cheap.price, cheap.flightID);
+        radj_price[r.to][r.bwdPos] = Arc(r.from, cheap.price, cheap.flightID);
+    }
 
-        if (flights.empty())
+    void noteEdgeSpeed(int u, int v, int duration)
+    {
+        if (!hasLocation[u] || !hasLocation[v] || u == v)
+            return;
+        if (duration <= 0)
         {
-            cout << "No flights available.\n";
+            instantEdge = true;
             return;
         }
+        maxSpeed = max(maxSpeed, greatCircleKm(u, v) / duration);
+    }
 
-        cout << "Flights departing between " << minutesToTime(earliestDep) << " and " << minutesToTime(latestDep) << ":\n";
+    int lowerBound(int v, int target) const
+    {
+        return (int)(greatCircleKm(v, target) / maxSpeed);
+    }
 
-        bool found = false;
-        for (size_t i = 0; i < flights.size(); ++i)
+    int route(const vector<vector<Arc>> &fwd, const vector<vector<Arc>> &bwd,
+              const string &src, const string &dest, vector<string> &path,
+              RouteSearchMode mode, bool useBound, RouteSearchStats *stats) const
+    {
+        RouteSearchStats local;
+        if (!stats)
+            stats = &local;
+        *stats = RouteSearchStats();
+        path.clear();
+        if (src == dest)
         {
-            const Flight &f = flights[i];
+            path.push_back(src);
+            return 0;
+        }
+        int s = findAirport(src);
+        int t = findAirport(dest);
+        if (s == -1 || t == -1)
+            return -1;
+        if (mode == SEARCH_BIDIRECTIONAL)
+            return bidirectional(fwd, bwd, s, t, path, *stats);
+        return dijkstra(fwd, s, t, useBound, path, *stats);
+    }
 
-            if (f.departureTime < 0 || f.departureTime > 1440)
-            {
-                cout << "Error: Invalid departure time for flight ID " << f.flightID << ". Skipping this flight.\n";
-                continue;
-            }
+    // Dijkstra, or A* when useBound is set (keys are dist + great-circle bound)
+    int dijkstra(const vector<vector<Arc>> &graph, int s, int t, bool useBound,
+                 vector<string> &path, RouteSearchStats &stats) const
+    {
+        static thread_local SearchScratch sc;
+        sc.reset(airportCodes.size());
 
-            if (f.departureTime >= earliestDep && f.departureTime <= latestDep)
+        sc.seen[s] = sc.stamp;
+        sc.dist[s] = 0;
+        sc.prev[s] = -1;
+        sc.bound[s] = useBound ? lowerBound(s, t) : 0;
+        sc.push(sc.bound[s], s);
+
+        {
+            TRACE_SPAN(useBound ? "astarExpand" : "dijkstraExpand");
+            while (!sc.heap.empty())
             {
-                found = true;
-                cout << "ID: " << f.flightID << " | " << f.source << "->" << f.destination
-                     << " | Dep: " << minutesToTime(f.departureTime)
-                     << " | Arr: " << minutesToTime(f.arrivalTime)
-                     << " | Seats: " << f.seatsAvailable << "/" << f.seatsTotal
-                     << " | Price: " << dynamicPrice(f) << endl;
+                pair<int, int> top = sc.pop();
+                int u = top.second;
+                int d = sc.dist[u];
+                if (top.first > d + sc.bound[u])
+                    continue; // stale entry
+                stats.nodesSettled++;
+                if (u == t)
+                    break;
+                const vector<Arc> &neighbors = graph[u];
+                for (size_t i = 0; i < neighbors.size(); ++i)
+                {
+                    int v = neighbors[i].to;
+                    int nd = d + neighbors[i].weight;
+                    stats.edgesRelaxed++;
+                    if (!sc.visited(v))
+                    {
+                        sc.seen[v] = sc.stamp;
+                        sc.dist[v] = INF_COST;
+                        sc.bound[v] = useBound ? lowerBound(v, t) : 0;
+                    }
+                    if (nd < sc.dist[v])
+                    {
+                        sc.dist[v] = nd;
+                        sc.prev[v] = u;
+                        sc.push(nd + sc.bound[v], v);
+                    }
+                }
             }
         }
+        if (sc.get(t) == INF_COST)
+            return -1;
 
-        if (!found)
+        TRACE_SPAN("reconstructPath");
+        for (int cur = t; cur != -1; cur = sc.prev[cur])
+            path.push_back(airportCodes[cur]);
+        reverse(path.begin(), path.end());
+        return sc.dist[t];
+    }
+
+    // Alternates a forward search over `fwd` and a backward one over `bwd`,
+    // always expanding the side with the smaller frontier key, and stops once
+    // the two frontiers together cannot beat the best meeting point found.
+    int bidirectional(const vector<vector<Arc>> &fwd, const vector<vector<Arc>> &bwd, int s, int t,
+                      vector<string> &path, RouteSearchStats &stats) const
+    {
+        TRACE_SPAN("bidirectionalSearch");
+        static thread_local SearchScratch forward, backward;
+        forward.reset(airportCodes.size());
+        backward.reset(airportCodes.size());
+
+        forward.seen[s] = forward.stamp;
+        forward.dist[s] = 0;
+        forward.prev[s] = -1;
+        forward.push(0, s);
+        backward.seen[t] = backward.stamp;
+        backward.dist[t] = 0;
+        backward.prev[t] = -1;
+        backward.push(0, t);
+
+        int best = INF_COST, meet = -1;
+        while (!forward.heap.empty() && !backward.heap.empty())
         {
-            cout << "No flights found within the specified time range.\n";
+            int topF = forward.heap.front().first, topB = backward.heap.front().first;
+            if (best != INF_COST && (long long)topF + topB >= best)
+                break;
+            bool isForward = topF <= topB;
+            SearchScratch &mine = isForward ? forward : backward;
+            const SearchScratch &other = isForward ? backward : forward;
+            const vector<vector<Arc>> &graph = isForward ? fwd : bwd;
+
+            pair<int, int> top = mine.pop();
+            int u = top.second;
+            int d = top.first;
+            if (d > mine.dist[u])
+                continue;
+            stats.nodesSettled++;
+            for (size_t i = 0; i < graph[u].size(); ++i)
+            {
+                int v = graph[u][i].to;
+                int nd = d + graph[u][i].weight;
+                stats.edgesRelaxed++;
+                if (nd < mine.get(v))
+                {
+                    mine.seen[v] = mine.stamp;
+                    mine.dist[v] = nd;
+                    mine.prev[v] = u;
+                    mine.push(nd, v);
+                }
+                int rest = other.get(v);
+                if (rest != INF_COST && nd + rest < best)
+                {
+                    best = nd + rest;
+                    meet = v;
+                }
+            }
         }
+        if (meet == -1)
+            return -1;
+
+        TRACE_SPAN("reconstructPath");
+        for (int cur = meet; cur != -1; cur = forward.prev[cur])
+            path.push_back(airportCodes[cur]);
+        reverse(path.begin(), path.end());
+        for (int cur = backward.prev[meet]; cur != -1; cur = backward.prev[cur])
+            path.push_back(airportCodes[cur]);
+        return best;
     }
+};
 
-    void bookFlight(string username, int flightID)
+// ---------------------- Contraction Hierarchy ----------------------
+// Shortcut index over the duration graph. Airports are contracted one by one
+// (cheapest first by edge difference); whenever removing an airport would
+// lengthen a shortest path, a shortcut edge remembering the two edges it
+// replaces is added. Queries then only walk "upward" edges from both ends.
+class ContractionHierarchy
+{
+public:
+    struct Edge
     {
-        int idx = binarySearchFlight(flightID);
-        if (idx == -1)
+        int from, to, weight;
+        int childA, childB; // replaced edges for shortcuts, -1 for real flights
+    };
+
+    vector<string> airportCodes;
+    unordered_map<string, int> airportIndex;
+    vector<int> rank;
+    vector<Edge> edges;
+    vector<vector<int>> up;   // edges to higher-ranked airports, by tail
+    vector<vector<int>> down; // edges from higher-ranked airports, by head
+    long long version;        // AirportGraph version the index was built from
+    int shortcuts = 0;
+    double buildMillis = 0;
+
+    ContractionHierarchy(const vector<vector<Arc>> &graph, const vector<string> &codes, long long graphVersion)
+        : airportCodes(codes), version(graphVersion)
+    {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        int n = codes.size();
+        for (int i = 0; i < n; ++i)
+            airportIndex[codes[i]] = i;
+        outArcs.assign(n, vector<WorkArc>());
+        inArcs.assign(n, vector<WorkArc>());
+        contracted.assign(n, false);
+        rank.assign(n, 0);
+
+        // Only the fastest of several parallel flights can be on a shortest path
+        for (int u = 0; u < n; ++u)
         {
-            cout << "Flight not found.\n";
-            return;
+            map<int, int> fastest;
+            for (size_t i = 0; i < graph[u].size(); ++i)
+            {
+                const Arc &a = graph[u][i];
+                if (a.to == u)
+                    continue;
+                map<int, int>::iterator it = fastest.find(a.to);
+                if (it == fastest.end() || a.weight < it->second)
+                    fastest[a.to] = a.weight;
+            }
+            for (map<int, int>::iterator it = fastest.begin(); it != fastest.end(); ++it)
+                addEdge(u, it->first, it->second, -1, -1);
         }
-        Flight &f = flights[idx];
-        if (f.seatsAvailable > 0)
+
+        vector<int> contractedNeighbors(n, 0), queued(n);
+        typedef pair<int, int> QElem;
+        priority_queue<QElem, vector<QElem>, greater<QElem>> order;
+        for (int v = 0; v < n; ++v)
         {
-            int seatNo = assignSeat(f);
-            f.bookings.push_back(Booking(username, seatNo));
-            passengers[username].bookings.push_back(flightID);
-            cout << "Seat booked! Flight " << flightID << ", Seat #" << seatNo
-                 << ", Price: " << dynamicPrice(f) << endl;
+            queued[v] = priority(v, 0);
+            order.push(make_pair(queued[v], v));
         }
-        else
+
+        up.assign(n, vector<int>());
+        down.assign(n, vector<int>());
+        int nextRank = 0;
+        while (!order.empty())
         {
-            cout << "No seats available. Added to waitlist.\n";
-            f.waitlist.push(username);
+            QElem top = order.top();
+            order.pop();
+            int v = top.second;
+            if (contracted[v] || top.first != queued[v])
+                continue; // superseded entry
+            // Lazy update: re-queue if the node got more expensive since it was queued
+            int p = priority(v, contractedNeighbors[v]);
+            if (!order.empty() && p > order.top().first)
+            {
+                queued[v] = p;
+                order.push(make_pair(p, v));
+                continue;
+            }
+            shortcuts += contract(v, true);
+            contracted[v] = true;
+            rank[v] = nextRank++;
+
+            // Whatever is still attached to v is ranked higher: these are its upward edges
+            vector<int> neighbors;
+            for (size_t i = 0; i < outArcs[v].size(); ++i)
+            {
+                const WorkArc &a = outArcs[v][i];
+                up[v].push_back(a.edge);
+                detach(inArcs[a.to], v);
+                neighbors.push_back(a.to);
+            }
+            for (size_t i = 0; i < inArcs[v].size(); ++i)
+            {
+                const WorkArc &a = inArcs[v][i];
+                down[v].push_back(a.edge);
+                detach(outArcs[a.to], v);
+                neighbors.push_back(a.to);
+            }
+            sort(neighbors.begin(), neighbors.end());
+            neighbors.erase(unique(neighbors.begin(), neighbors.end()), neighbors.end());
+            for (size_t i = 0; i < neighbors.size(); ++i)
+                contractedNeighbors[neighbors[i]]++;
         }
+        outArcs.clear();
+        inArcs.clear();
+        contracted.clear();
+        buildMillis = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
     }
 
-    void cancelBooking(string username, int flightID)
+    // Same contract as AirportGraph::shortestRoute
+    int shortestRoute(const string &src, const string &dest, vector<string> &path,
+                      RouteSearchStats *stats = NULL) const
     {
-        int idx = binarySearchFlight(flightID);
-        if (idx == -1)
+        RouteSearchStats local;
+        if (!stats)
+            stats = &local;
+        *stats = RouteSearchStats();
+        path.clear();
+        if (src == dest)
         {
-            cout << "Flight not found.\n";
-            return;
+            path.push_back(src);
+            return 0;
         }
-        Flight &f = flights[idx];
-        bool found = false;
-        for (size_t i = 0; i < f.bookings.size(); ++i)
+        unordered_map<string, int>::const_iterator si = airportIndex.find(src), ti = airportIndex.find(dest);
+        if (si == airportIndex.end() || ti == airportIndex.end())
+            return -1;
+        int s = si->second, t = ti->second;
+
+        TRACE_SPAN("hierarchyQuery");
+        static thread_local SearchScratch forward, backward;
+        forward.reset(airportCodes.size());
+        backward.reset(airportCodes.size());
+        forward.seen[s] = forward.stamp;
+        forward.dist[s] = 0;
+        forward.prev[s] = -1;
+        forward.push(0, s);
+        backward.seen[t] = backward.stamp;
+        backward.dist[t] = 0;
+        backward.prev[t] = -1;
+        backward.push(0, t);
+
+        int best = INF_COST, meet = -1;
+        while (!forward.heap.empty() || !backward.heap.empty())
         {
-            Booking &b = f.bookings[i];
-            if (b.passengerUsername == username && b.active)
+            bool isForward = !forward.heap.empty() &&
+                             (backward.heap.empty() || forward.heap.front().first <= backward.heap.front().first);
+            SearchScratch &mine = isForward ? forward : backward;
+            const SearchScratch &other = isForward ? backward : forward;
+            if (mine.heap.front().first >= best)
             {
-                b.active = false;
-                f.seatMap[b.seatNo - 1] = false;
-                f.seatsAvailable++;
-                found = true;
-                break;
+                mine.heap.clear(); // this side cannot improve the answer any more
+                continue;
             }
-        }
-        if (found)
-        {
-            cout << "Booking cancelled.\n";
-            // Assign seat to waitlist if any
-            if (!f.waitlist.empty())
+            pair<int, int> top = mine.pop();
+            int u = top.second, d = top.first;
+            if (d > mine.dist[u])
+                continue;
+            stats->nodesSettled++;
+            int rest = other.get(u);
+            if (rest != INF_COST && d + rest < best)
             {
-                string nextUser = f.waitlist.front();
-                f.waitlist.pop();
-                int seatNo = assignSeat(f);
-                f.bookings.push_back(Booking(nextUser, seatNo));
-                passengers[nextUser].bookings.push_back(flightID);
-                cout << "Waitlisted passenger " << nextUser << " booked on this flight, seat #" << seatNo << endl;
+                best = d + rest;
+                meet = u;
+            }
+            const vector<int> &arcs = isForward ? up[u] : down[u];
+            for (size_t i = 0; i < arcs.size(); ++i)
+            {
+                const Edge &e = edges[arcs[i]];
+                int v = isForward ? e.to : e.from;
+                int nd = d + e.weight;
+                stats->edgesRelaxed++;
+                if (nd < mine.get(v))
+                {
+                    mine.seen[v] = mine.stamp;
+                    mine.dist[v] = nd;
+                    mine.prev[v] = arcs[i];
+                    mine.push(nd, v);
+                }
             }
         }
-        else
-        {
-            cout << "No active booking found for this user on this flight.\n";
-        }
+        if (meet == -1)
+            return -1;
+
+        TRACE_SPAN("unpackShortcuts");
+        vector<int> route;
+        for (int cur = meet; forward.prev[cur] != -1; cur = edges[forward.prev[cur]].from)
+            route.push_back(forward.prev[cur]);
+        reverse(route.begin(), route.end());
+        for (int cur = meet; backward.prev[cur] != -1; cur = edges[backward.prev[cur]].to)
+            route.push_back(backward.prev[cur]);
+
+        path.push_back(src);
+        for (size_t i = 0; i < route.size(); ++i)
+            unpack(route[i], path);
+        return best;
     }
 
-    void listPassengerBookings(string username)
+private:
+    struct WorkArc
     {
-        if (!passengers.count(username))
+        int to, weight, edge;
+    };
+    // Remaining graph while contracting; released once the index is built
+    vector<vector<WorkArc>> outArcs, inArcs;
+    vector<bool> contracted;
+    SearchScratch witness;
+
+    // Adds u->v, or lowers the existing u->v arc, so each airport pair keeps one arc
+    void addEdge(int u, int v, int w, int childA, int childB)
+    {
+        Edge e = {u, v, w, childA, childB};
+        int id = edges.size();
+        for (size_t i = 0; i < outArcs[u].size(); ++i)
         {
-            cout << "Passenger not found.\n";
+            if (outArcs[u][i].to != v)
+                continue;
+            if (w >= outArcs[u][i].weight)
+                return;
+            edges.push_back(e);
+            outArcs[u][i].weight = w;
+            outArcs[u][i].edge = id;
+            for (size_t j = 0; j < inArcs[v].size(); ++j)
+                if (inArcs[v][j].to == u)
+                {
+                    inArcs[v][j].weight = w;
+                    inArcs[v][j].edge = id;
+                }
             return;
         }
+        edges.push_back(e);
+        WorkArc fwd = {v, w, id};
+        WorkArc bwd = {u, w, id};
+        outArcs[u].push_back(fwd);
+        inArcs[v].push_back(bwd);
+    }
 
-        cout << "Bookings for " << username << ":\n";
+    static void detach(vector<WorkArc> &arcs, int v)
+    {
+        for (size_t i = 0; i < arcs.size(); ++i)
+            if (arcs[i].to == v)
+            {
+                arcs[i] = arcs.back();
+                arcs.pop_back();
+                return;
+            }
+    }
 
-        bool foundBooking = false;
+    // Edge difference plus a penalty for already-contracted neighbours, which
+    // spreads contraction evenly over the network
+    int priority(int v, int contractedNeighbors)
+    {
+        int degree = outArcs[v].size() + inArcs[v].size();
+        return 2 * (contract(v, false) - degree) + contractedNeighbors;
+    }
 
-        for (Flight &f : flights)
+    // Counts (and with apply, adds) the shortcuts needed to remove v. A
+    // bounded local search from each predecessor looks for a witness path
+    // that avoids v and is no longer than going through it.
+    int contract(int v, bool apply)
+    {
+        const int settleLimit = apply ? 500 : 50;
+        int added = 0;
+        vector<WorkArc> ins = inArcs[v], outs = outArcs[v];
+        for (size_t i = 0; i < ins.size(); ++i)
         {
-            for (Booking &b : f.bookings)
+            int u = ins[i].to;
+            int limit = 0;
+            for (size_t j = 0; j < outs.size(); ++j)
+                if (outs[j].to != u)
+                    limit = max(limit, ins[i].weight + outs[j].weight);
+            if (limit == 0)
+                continue;
+
+            witness.reset(outArcs.size());
+            witness.seen[u] = witness.stamp;
+            witness.dist[u] = 0;
+            witness.push(0, u);
+            int settled = 0;
+            while (!witness.heap.empty() && settled < settleLimit)
             {
-                if (b.passengerUsername == username && b.active)
+                pair<int, int> top = witness.pop();
+                int x = top.second;
+                if (top.first > witness.dist[x])
+                    continue;
+                if (top.first > limit)
+                    break;
+                settled++;
+                for (size_t k = 0; k < outArcs[x].size(); ++k)
                 {
-                    foundBooking = true;
-                    cout << "Flight " << f.flightID << " | " << f.source << "->" << f.destination
-                         << " | Dep: " << minutesToTime(f.departureTime)
-                         << " | Seat #" << b.seatNo << endl;
+                    const WorkArc &a = outArcs[x][k];
+                    if (a.to == v)
+                        continue;
+                    int nd = top.first + a.weight;
+                    if (nd < witness.get(a.to))
+                    {
+                        witness.seen[a.to] = witness.stamp;
+                        witness.dist[a.to] = nd;
+                        witness.push(nd, a.to);
+                    }
                 }
             }
-        }
 
-        if (!foundBooking)
-        {
-            cout << "No bookings available.\n";
+            for (size_t j = 0; j < outs.size(); ++j)
+            {
+                int x = outs[j].to;
+                if (x == u)
+                    continue;
+                int viaV = ins[i].weight + outs[j].weight;
+                if (witness.get(x) <= viaV)
+                    continue;
+                added++;
+                if (apply)
+                    addEdge(u, x, viaV, ins[i].edge, outs[j].edge);
+            }
         }
+        return added;
     }
 
-    // --- Route Optimization ---
-    void findShortestRoute(string src, string dest)
+    void unpack(int e, vector<string> &path) const
     {
-        vector<string> path;
-        int mins = airportGraph.shortestRoute(src, dest, path);
-        if (mins == -1)
-            cout << "No route found.\n";
-        else
+        if (edges[e].childA == -1)
         {
-            cout << "Shortest route (" << mins << " mins): ";
-            for (size_t i = 0; i < path.size(); ++i)
-            {
-                cout << path[i];
-                if (i < path.size() - 1)
-                    cout << " -> ";
-            }
-            cout << endl;
+            path.push_back(airportCodes[edges[e].to]);
+            return;
         }
+        unpack(edges[e].childA, path);
+        unpack(edges[e].childB, path);
     }
-    void findCheapestRoute(string src, string dest)
+};
+
+// Rebuilds an index on a background thread. Each request hands over a
+// build job that owns copies of the graph data it reads, so the builder never
+// touches live state; requests that arrive mid-build coalesce into one
+// rebuild.
+template <typename Index>
+class BackgroundBuilder
+{
+public:
+    typedef function<shared_ptr<const Index>()> Job;
+
+    BackgroundBuilder() : stopping(false), busy(false) {}
+    ~BackgroundBuilder()
     {
-        vector<string> path;
-        int mins = airportGraph.cheapestRoute(src, dest, path);
-        if (mins == -1)
-            cout << "No route found.\n";
-        else
         {
-            cout << "Cheapest route (" << mins << " INR): ";
-            for (size_t i = 0; i < path.size(); ++i)
-            {
-                cout << path[i];
-                if (i < path.size() - 1)
-                    cout << " -> ";
-            }
-            cout << endl;
+            lock_guard<mutex> guard(lock);
+            stopping = true;
         }
+        wake.notify_all();
+        if (worker.joinable())
+            worker.join();
     }
 
-    // --- Reporting ---
-    void flightOccupancyReport()
+    shared_ptr<const Index> current() const
+    {
+        lock_guard<mutex> guard(lock);
+        return published;
+    }
+
+    bool building() const
+    {
+        lock_guard<mutex> guard(lock);
+        return busy || job;
+    }
+
+    void clear()
+    {
+        lock_guard<mutex> guard(lock);
+        job = NULL;
+        published.reset();
+    }
+
+protected:
+    void queue(Job build)
     {
-        cout << "Flight Occupancy Report:\n";
-        for (size_t i = 0; i < flights.size(); ++i)
         {
-            const Flight &f = flights[i];
-            double occ = 100.0 * (f.seatsTotal - f.seatsAvailable) / f.seatsTotal;
-            cout << "Flight " << f.flightID << ": " << occ << "% full\n";
+            lock_guard<mutex> guard(lock);
+            job = move(build);
+            if (!worker.joinable())
+                worker = thread(&BackgroundBuilder::run, this);
         }
+        wake.notify_all();
     }
 
-    void waitlistReport()
+private:
+    mutable mutex lock;
+    condition_variable wake;
+    thread worker;
+    bool stopping, busy;
+    Job job;
+    shared_ptr<const Index> published;
+
+    void run()
     {
-        cout << "Waitlist Report:\n";
-        for (size_t i = 0; i < flights.size(); ++i)
+        unique_lock<mutex> guard(lock);
+        while (true)
         {
-            const Flight &f = flights[i];
-            cout << "Flight " << f.flightID << ": " << f.waitlist.size() << " on waitlist\n";
+            wake.wait(guard, [this]
+                      { return stopping || job; });
+            if (stopping)
+                return;
+            Job build;
+            build.swap(job);
+            busy = true;
+            guard.unlock();
+            shared_ptr<const Index> built = build();
+            guard.lock();
+            busy = false;
+            if (!job)
+                published = built; // skip publishing when a newer schedule is already queued
         }
     }
-    void printAllDuties();
 };
-void AirlinesSystem::printAllDuties()
+
+class RouteIndexBuilder : public BackgroundBuilder<ContractionHierarchy>
 {
-    cout << "\n----- Crew Duties -----\n";
-    for (const auto &pair : crew)
+public:
+    void requestRebuild(const AirportGraph &g)
     {
-        const CrewMember &c = pair.second;
-        cout << "Crew ID: " << c.id << " | Role: " << c.role << "\n";
-        if (c.assignedFlights.empty())
-        {
-            cout << "  No flights assigned.\n";
-        }
-        else
+        queue([graph = g.adj, codes = g.airportCodes, version = g.version]()
+              { return make_shared<ContractionHierarchy>(graph, codes, version); });
+    }
+};
+
+// ---------------------- All-Pairs Distance Table ----------------------
+// Dense duration and price matrices with next-hop tables, filled by a blocked
+// Floyd-Warshall. Meant for regional networks of a few hundred airports,
+// where precomputing every answer is cheaper than searching per query.
+class DistanceTable
+{
+public:
+    static constexpr int MAX_AIRPORTS = 2048;
+    static constexpr int UNREACHABLE = 1 << 29; // INF + INF still fits in an int
+
+    long long version = -1; // AirportGraph version the table was built from
+    int n = 0;
+    vector<int> duration, price;         // row-major n x n
+    vector<int> nextDuration, nextPrice; // first hop from row airport toward column airport
+    double buildMillis = 0;
+
+    bool current(const AirportGraph &g) const { return version == g.version && n == (int)g.airportCodes.size(); }
+
+    // Returns false (leaving the table empty) when the network is too large
+    bool build(const AirportGraph &g) { return build(g.adj, g.adj_price, g.version); }
+
+    bool build(const vector<vector<Arc>> &byDuration, const vector<vector<Arc>> &byPrice, long long graphVersion)
+    {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        n = byDuration.size();
+        version = graphVersion;
+        if (n > MAX_AIRPORTS)
         {
-            for (int fid : c.assignedFlights)
-            {
-                auto it = find_if(flights.begin(), flights.end(), [&](const Flight &f)
-                                  { return f.flightID == fid; });
-                if (it != flights.end())
-                {
-                    cout << "  Flight ID: " << it->flightID
-                         << " | Departure: " << it->departureTime
-                         << " | Arrival: " << it->arrivalTime << "\n";
-                }
-                else
-                {
-                    cout << "  Flight ID: " << fid << " (details not found)\n";
-                }
-            }
+            n = 0;
+            duration.clear();
+            price.clear();
+            nextDuration.clear();
+            nextPrice.clear();
+            return false;
         }
-        cout << "-------------------------\n";
+        fill(duration, nextDuration, byDuration);
+        fill(price, nextPrice, byPrice);
+        closure(duration, nextDuration);
+        closure(price, nextPrice);
+        buildMillis = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        return true;
     }
-}
 
-// ---------------------- Main Menu ----------------------
-void adminMenu(AirlinesSystem &sys)
-{
-    while (true)
+    // O(1) cost lookup; -1 when unreachable
+    int cost(const vector<int> &matrix, int s, int t) const
     {
-        cout << "\n--- Admin Menu ---\n";
+        int c = matrix[(size_t)s * n + t];
+        return c >= UNREACHABLE ? -1 : c;
+    }
+
+    // Walks the next-hop table in O(path length)
+    int route(const AirportGraph &g, bool byPrice, const string &src, const string &dest, vector<string> &path) const
+    {
+        path.clear();
+        if (src == dest)
+        {
+            path.push_back(src);
+            return 0;
+        }
+        int s = g.findAirport(src), t = g.findAirport(dest);
+        if (s == -1 || t == -1 || s >= n || t >= n)
+            return -1;
+        const vector<int> &matrix = byPrice ? price : duration;
+        const vector<int> &next = byPrice ? nextPrice : nextDuration;
+        int c = cost(matrix, s, t);
+        if (c == -1)
+            return -1;
+        for (int cur = s; cur != t; cur = next[(size_t)cur * n + t])
+            path.push_back(g.airportCodes[cur]);
+        path.push_back(dest);
+        return c;
+    }
+
+private:
+    static constexpr int BLOCK = 64;
+
+    void fill(vector<int> &dist, vector<int> &next, const vector<vector<Arc>> &graph)
+    {
+        dist.assign((size_t)n * n, UNREACHABLE);
+        next.assign((size_t)n * n, -1);
+        for (int u = 0; u < n; ++u)
+        {
+            dist[(size_t)u * n + u] = 0;
+            next[(size_t)u * n + u] = u;
+            for (size_t i = 0; i < graph[u].size(); ++i)
+            {
+                size_t cell = (size_t)u * n + graph[u][i].to;
+                if (graph[u][i].weight < dist[cell])
+                {
+                    dist[cell] = graph[u][i].weight;
+                    next[cell] = graph[u][i].to;
+                }
+            }
+        }
+    }
+
+    // Three-phase blocked Floyd-Warshall: for each pivot block, first the
+    // diagonal block, then its row and column, then everything else, so each
+    // step works on three cache-resident tiles.
+    void closure(vector<int> &dist, vector<int> &next)
+    {
+        int blocks = (n + BLOCK - 1) / BLOCK;
+        for (int kb = 0; kb < blocks; ++kb)
+        {
+            relaxTile(dist, next, kb, kb, kb);
+            for (int b = 0; b < blocks; ++b)
+            {
+                if (b == kb)
+                    continue;
+                relaxTile(dist, next, kb, b, kb);
+                relaxTile(dist, next, b, kb, kb);
+            }
+            for (int ib = 0; ib < blocks; ++ib)
+                for (int jb = 0; jb < blocks; ++jb)
+                    if (ib != kb && jb != kb)
+                        relaxTile(dist, next, ib, jb, kb);
+        }
+    }
+
+    // Each tile update runs over contiguous rows, four cells at a time with
+    // GCC/Clang vector extensions (SSE on x86, NEON on ARM).
+    void relaxTile(vector<int> &dist, vector<int> &next, int ib, int jb, int kb)
+    {
+        int i0 = ib * BLOCK, i1 = min(n, i0 + BLOCK);
+        int j0 = jb * BLOCK, j1 = min(n, j0 + BLOCK);
+        int k0 = kb * BLOCK, k1 = min(n, k0 + BLOCK);
+        for (int k = k0; k < k1; ++k)
+        {
+            const int *dk = &dist[(size_t)k * n];
+            for (int i = i0; i < i1; ++i)
+            {
+                if (i == k)
+                    continue; // row k cannot improve through itself
+                int *di = &dist[(size_t)i * n];
+                int *ni = &next[(size_t)i * n];
+                int dik = di[k];
+                if (dik >= UNREACHABLE)
+                    continue;
+                relaxRow(di + j0, ni + j0, dk + j0, dik, ni[k], j1 - j0);
+            }
+        }
+    }
+
+    static void relaxRow(int *__restrict di, int *__restrict ni, const int *__restrict dk,
+                         int dik, int nik, int count)
+    {
+        int j = 0;
+#if defined(__GNUC__)
+        typedef int Lanes __attribute__((vector_size(16)));
+        Lanes pivot = {dik, dik, dik, dik}, hop = {nik, nik, nik, nik};
+        for (; j + 4 <= count; j += 4)
+        {
+            Lanes d, nx, viaK;
+            memcpy(&d, di + j, sizeof(d));
+            memcpy(&nx, ni + j, sizeof(nx));
+            memcpy(&viaK, dk + j, sizeof(viaK));
+            viaK += pivot;
+            Lanes better = viaK < d; // all ones where the pivot helps
+            d = (viaK & better) | (d & ~better);
+            nx = (hop & better) | (nx & ~better);
+            memcpy(di + j, &d, sizeof(d));
+            memcpy(ni + j, &nx, sizeof(nx));
+        }
+#endif
+        for (; j < count; ++j)
+        {
+            int candidate = dik + dk[j];
+            if (candidate < di[j])
+            {
+                di[j] = candidate;
+                ni[j] = nik;
+            }
+        }
+    }
+};
+
+class DistanceTableBuilder : public BackgroundBuilder<DistanceTable>
+{
+public:
+    void requestRebuild(const AirportGraph &g)
+    {
+        queue([byDuration = g.adj, byPrice = g.adj_price, version = g.version]()
+              {
+            shared_ptr<DistanceTable> table = make_shared<DistanceTable>();
+            table->build(byDuration, byPrice, version);
+            return shared_ptr<const DistanceTable>(table); });
+    }
+};
+
+// ---------------------- Work-Stealing Thread Pool ----------------------
+// Each worker owns a deque: it takes work from the back of its own and, when
+// that runs dry, steals from the front of the others. run() blocks until the
+// whole batch has finished. Tasks carry their batch's generation, and a
+// worker only takes tasks of the generation it woke for, so a worker
+// leaving one batch never counts a task of the next against it.
+class WorkStealingPool
+{
+public:
+    explicit WorkStealingPool(int threadCount) : generation(0), pending(0), stopping(false)
+    {
+        threadCount = max(1, threadCount);
+        for (int i = 0; i < threadCount; ++i)
+            queues.push_back(unique_ptr<WorkQueue>(new WorkQueue()));
+        for (int i = 0; i < threadCount; ++i)
+            workers.push_back(thread(&WorkStealingPool::workerLoop, this, i));
+    }
+
+    ~WorkStealingPool()
+    {
+        {
+            lock_guard<mutex> guard(stateLock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (size_t i = 0; i < workers.size(); ++i)
+            workers[i].join();
+    }
+
+    int size() const { return workers.size(); }
+
+    void run(vector<function<void()>> &tasks)
+    {
+        if (tasks.empty())
+            return;
+        // The count must be in place before any worker can finish a task
+        unique_lock<mutex> guard(stateLock);
+        pending = tasks.size();
+        long long batch = ++generation;
+        for (size_t i = 0; i < tasks.size(); ++i)
+        {
+            WorkQueue &q = *queues[i % queues.size()];
+            lock_guard<mutex> queueGuard(q.lock);
+            q.tasks.push_back(Task(batch, &tasks[i]));
+        }
+        wake.notify_all();
+        done.wait(guard, [this]
+                  { return pending == 0; });
+    }
+
+private:
+    typedef pair<long long, function<void()> *> Task; // generation, work
+    struct WorkQueue
+    {
+        mutex lock;
+        deque<Task> tasks;
+    };
+    vector<unique_ptr<WorkQueue>> queues;
+    vector<thread> workers;
+    mutex stateLock;
+    condition_variable wake, done;
+    long long generation;
+    size_t pending;
+    bool stopping;
+
+    function<void()> *takeTask(int self, long long batch)
+    {
+        {
+            WorkQueue &own = *queues[self];
+            lock_guard<mutex> guard(own.lock);
+            if (!own.tasks.empty() && own.tasks.back().first == batch)
+            {
+                function<void()> *task = own.tasks.back().second;
+                own.tasks.pop_back();
+                return task;
+            }
+        }
+        for (size_t i = 1; i < queues.size(); ++i)
+        {
+            WorkQueue &victim = *queues[(self + i) % queues.size()];
+            lock_guard<mutex> guard(victim.lock);
+            if (!victim.tasks.empty() && victim.tasks.front().first == batch)
+            {
+                function<void()> *task = victim.tasks.front().second;
+                victim.tasks.pop_front();
+                return task;
+            }
+        }
+        return NULL;
+    }
+
+    void workerLoop(int self)
+    {
+        long long seen = 0;
+        while (true)
+        {
+            {
+                unique_lock<mutex> guard(stateLock);
+                wake.wait(guard, [&]
+                          { return stopping || generation != seen; });
+                if (stopping)
+                    return;
+                seen = generation;
+            }
+            while (function<void()> *task = takeTask(self, seen))
+            {
+                (*task)();
+                lock_guard<mutex> guard(stateLock);
+                if (--pending == 0)
+                    done.notify_all();
+            }
+        }
+    }
+};
+
+// ---------------------- Batch Route Queries ----------------------
+// Groups queries by (source, metric) so each group costs one one-to-many
+// search, then spreads the groups over the pool. The graph is only read.
+vector<RouteResult> batchRoutes(const AirportGraph &g, const vector<RouteQuery> &queries, WorkStealingPool &pool)
+{
+    vector<RouteResult> results(queries.size());
+    map<pair<string, bool>, vector<size_t>> groups;
+    for (size_t i = 0; i < queries.size(); ++i)
+        groups[make_pair(queries[i].src, queries[i].byPrice)].push_back(i);
+
+    vector<function<void()>> tasks;
+    for (map<pair<string, bool>, vector<size_t>>::iterator it = groups.begin(); it != groups.end(); ++it)
+    {
+        const string &src = it->first.first;
+        bool byPrice = it->first.second;
+        const vector<size_t> &members = it->second;
+        tasks.push_back([&g, &queries, &results, &src, byPrice, &members]()
+                        {
+            vector<string> dests;
+            for (size_t i = 0; i < members.size(); ++i)
+                dests.push_back(queries[members[i]].dest);
+            vector<RouteResult> found;
+            g.routesFrom(src, dests, byPrice, found);
+            for (size_t i = 0; i < members.size(); ++i)
+                swap(results[members[i]], found[i]); });
+    }
+    pool.run(tasks);
+    return results;
+}
+
+// ---------------------- Benchmark Harness ----------------------
+// Shared by the benchmark options and their self tests. A Benchmark owns the
+// seeded generator its fixture is drawn from, a stream that swallows what
+// fixture systems print, and a stopwatch. Every cross-check goes through
+// mismatches() or audit(), so failures() is zero when they all agreed. The
+// report's number format is restored when the benchmark ends.
+class Benchmark
+{
+    NullBuffer sink;
+
+public:
+    ostream &os;   // results table
+    mt19937 rng;   // fixed seeds keep runs comparable
+    ostream quiet; // hand this to fixture systems and routers
+
+    explicit Benchmark(ostream &report, unsigned seed = 1)
+        : os(report), rng(seed), quiet(&sink), savedFlags(report.flags()), savedPrecision(report.precision()),
+          began(chrono::steady_clock::now())
+    {
+    }
+    ~Benchmark()
+    {
+        os.flags(savedFlags);
+        os.precision(savedPrecision);
+    }
+
+    void startTimer() { began = chrono::steady_clock::now(); }
+    // Seconds since startTimer()
+    double elapsed() const { return chrono::duration<double>(chrono::steady_clock::now() - began).count(); }
+
+    // Counts a cross-check's mismatches and passes them on for a table column
+    long long mismatches(long long n)
+    {
+        failed += n;
+        return n;
+    }
+    void reportMismatches(long long n) { os << "Mismatches: " << mismatches(n) << "\n"; }
+    // Audit column of a consistency check
+    const char *audit(bool consistent)
+    {
+        failed += !consistent;
+        return consistent ? "ok" : "MISMATCH";
+    }
+    long long failures() const { return failed; }
+
+private:
+    ios::fmtflags savedFlags;
+    streamsize savedPrecision;
+    chrono::steady_clock::time_point began;
+    long long failed = 0;
+};
+
+// ---------------------- Route Search Benchmark ----------------------
+// Builds a synthetic global hub-and-spoke network: every twentieth airport is
+// a hub linked to its nearest hubs plus one long-haul hub, and every other
+// airport flies to its nearest hubs and neighbours. Flights run both ways.
+void buildSyntheticNetwork(AirportGraph &g, int airports, unsigned seed)
+{
+    mt19937 rng(seed);
+    uniform_real_distribution<double> latDist(-55.0, 70.0), lonDist(-180.0, 180.0);
+    vector<int> ids(airports), hubs;
+    for (int i = 0; i < airports; ++i)
+    {
+        ostringstream oss;
+        oss << "A" << setw(5) << setfill('0') << i;
+        ids[i] = g.internAirport(oss.str());
+        g.setAirportLocation(oss.str(), latDist(rng), lonDist(rng));
+        if (i % 20 == 0)
+            hubs.push_back(i);
+    }
+
+    int flightID = 1;
+    set<pair<int, int>> linked;
+    // k closest airports to `from` among `pool`
+    auto nearest = [&](int from, const vector<int> &pool, int k)
+    {
+        vector<pair<double, int>> byDistance;
+        for (int j : pool)
+            if (j != from)
+                byDistance.push_back(make_pair(g.greatCircleKm(ids[from], ids[j]), j));
+        k = min(k, (int)byDistance.size());
+        partial_sort(byDistance.begin(), byDistance.begin() + k, byDistance.end());
+        vector<int> result;
+        for (int i = 0; i < k; ++i)
+            result.push_back(byDistance[i].second);
+        return result;
+    };
+    auto link = [&](int a, int b)
+    {
+        if (a == b || !linked.insert(make_pair(min(a, b), max(a, b))).second)
+            return;
+        double km = g.greatCircleKm(ids[a], ids[b]);
+        int mins = 30 + (int)(km / 13.0); // taxi/climb overhead + ~800 km/h cruise
+        const string &ca = g.airportCodes[ids[a]], &cb = g.airportCodes[ids[b]];
+        g.addFlight(Flight(flightID++, ca, cb, 0, mins, 100, 1500 + km * 4));
+        g.addFlight(Flight(flightID++, cb, ca, 0, mins, 100, 1500 + km * 4));
+    };
+
+    vector<int> all(airports);
+    for (int i = 0; i < airports; ++i)
+        all[i] = i;
+    uniform_int_distribution<int> anyHub(0, hubs.size() - 1);
+    for (int h : hubs)
+    {
+        for (int other : nearest(h, hubs, 6))
+            link(h, other);
+        link(h, hubs[anyHub(rng)]); // long-haul
+    }
+    for (int i = 0; i < airports; ++i)
+    {
+        if (i % 20 == 0)
+            continue;
+        for (int h : nearest(i, hubs, 2))
+            link(i, h);
+        for (int j : nearest(i, all, 2))
+            link(i, j);
+    }
+}
+
+long long runRouteBenchmark(ostream &os, int airports, int queries)
+{
+    Benchmark bench(os, 7);
+    AirportGraph g;
+    os << "Building synthetic network of " << airports << " airports...\n";
+    buildSyntheticNetwork(g, airports, 42);
+
+    uniform_int_distribution<int> pick(0, airports - 1);
+    vector<pair<string, string>> pairs;
+    for (int i = 0; i < queries; ++i)
+        pairs.push_back(make_pair(g.airportCodes[pick(bench.rng)], g.airportCodes[pick(bench.rng)]));
+
+    const char *names[] = {"Dijkstra", "Bidirectional", "A*"};
+    RouteSearchMode modes[] = {SEARCH_DIJKSTRA, SEARCH_BIDIRECTIONAL, SEARCH_ASTAR};
+    vector<int> reference(queries);
+    os << left << setw(16) << "Mode" << setw(18) << "Avg settled" << setw(18) << "Avg latency(us)" << "Mismatches\n";
+    for (int m = 0; m < 3; ++m)
+    {
+        long long settled = 0;
+        int mismatches = 0;
+        vector<string> path;
+        bench.startTimer();
+        for (int i = 0; i < queries; ++i)
+        {
+            RouteSearchStats stats;
+            int cost = g.shortestRoute(pairs[i].first, pairs[i].second, path, modes[m], &stats);
+            settled += stats.nodesSettled;
+            if (m == 0)
+                reference[i] = cost;
+            else if (cost != reference[i])
+                mismatches++;
+        }
+        double us = bench.elapsed() * 1e6;
+        os << left << setw(16) << names[m] << setw(18) << settled / max(1, queries)
+           << setw(18) << fixed << setprecision(1) << us / max(1, queries) << bench.mismatches(mismatches) << "\n";
+    }
+
+    ContractionHierarchy ch(g.adj, g.airportCodes, g.version);
+    long long settled = 0;
+    int mismatches = 0;
+    vector<string> path;
+    bench.startTimer();
+    for (int i = 0; i < queries; ++i)
+    {
+        RouteSearchStats stats;
+        if (ch.shortestRoute(pairs[i].first, pairs[i].second, path, &stats) != reference[i])
+            mismatches++;
+        settled += stats.nodesSettled;
+    }
+    double us = bench.elapsed() * 1e6;
+    os << left << setw(16) << "CH" << setw(18) << settled / max(1, queries)
+       << setw(18) << fixed << setprecision(1) << us / max(1, queries) << bench.mismatches(mismatches) << "\n";
+    os << "CH preprocessing: " << ch.buildMillis << " ms, " << ch.shortcuts << " shortcuts\n";
+
+    if (airports <= 1000)
+    {
+        DistanceTable table;
+        table.build(g);
+        mismatches = 0;
+        bench.startTimer();
+        for (int i = 0; i < queries; ++i)
+            if (table.route(g, false, pairs[i].first, pairs[i].second, path) != reference[i])
+                mismatches++;
+        us = bench.elapsed() * 1e6;
+        os << left << setw(16) << "All-pairs" << setw(18) << 0
+           << setw(18) << fixed << setprecision(1) << us / max(1, queries) << bench.mismatches(mismatches) << "\n";
+        os << "All-pairs preprocessing: " << table.buildMillis << " ms\n";
+    }
+    return bench.failures();
+}
+
+
+// Measures batch throughput on a synthetic network as the pool grows from
+// one thread to every core, against answering each query on its own. Every
+// batch must find the same costs as the one-at-a-time answers.
+long long runBatchRouteBenchmark(ostream &os, int airports, int queries)
+{
+    Benchmark bench(os, 11);
+    AirportGraph g;
+    os << "Building synthetic network of " << airports << " airports...\n";
+    buildSyntheticNetwork(g, airports, 42);
+
+    // Fare shopping traffic concentrates on a limited set of origins
+    uniform_int_distribution<int> pick(0, airports - 1);
+    vector<string> origins;
+    for (int i = 0; i < max(1, airports / 20); ++i)
+        origins.push_back(g.airportCodes[pick(bench.rng)]);
+    uniform_int_distribution<int> pickOrigin(0, origins.size() - 1);
+    vector<RouteQuery> batch;
+    for (int i = 0; i < queries; ++i)
+        batch.push_back(RouteQuery(origins[pickOrigin(bench.rng)], g.airportCodes[pick(bench.rng)], i % 2 == 1));
+
+    vector<string> path;
+    vector<int> reference(batch.size());
+    bench.startTimer();
+    for (size_t i = 0; i < batch.size(); ++i)
+    {
+        if (batch[i].byPrice)
+            reference[i] = g.cheapestRoute(batch[i].src, batch[i].dest, path);
+        else
+            reference[i] = g.shortestRoute(batch[i].src, batch[i].dest, path);
+    }
+    double baseline = queries / bench.elapsed();
+    os << "One query at a time: " << fixed << setprecision(0) << baseline << " queries/s\n";
+
+    int cores = max(1u, thread::hardware_concurrency());
+    double single = 0;
+    long long mismatches = 0;
+    for (int threads = 1;; threads = min(cores, threads * 2))
+    {
+        WorkStealingPool pool(threads);
+        bench.startTimer();
+        vector<RouteResult> results = batchRoutes(g, batch, pool);
+        double rate = queries / bench.elapsed();
+        if (threads == 1)
+            single = rate;
+        for (size_t i = 0; i < results.size(); ++i)
+            mismatches += results[i].cost != reference[i];
+        os << "Batch, " << threads << " thread(s): " << rate << " queries/s (x"
+           << setprecision(2) << rate / single << " vs 1 thread)\n"
+           << setprecision(0);
+        if (threads == cores)
+            break;
+    }
+    bench.reportMismatches(mismatches);
+    return bench.failures();
+}
+
+// ---------------------- Timing Wheel ----------------------
+// Hierarchical timing wheel (4 levels x 256 slots, 1 ms ticks, ~49 days of
+// range). Timers live in a pooled intrusive list per slot, so schedule and
+// cancel are O(1); a timer far in the future sits in a coarse level and is
+// cascaded down once when its slot comes round.
+class TimingWheel
+{
+public:
+    static constexpr int LEVELS = 4;
+    static constexpr int SLOT_BITS = 8;
+    static constexpr int SLOTS = 1 << SLOT_BITS;
+
+    explicit TimingWheel(uint64_t startTick = 0) : current(startTick), active(0)
+    {
+        slotHead.assign(LEVELS * SLOTS, -1);
+    }
+
+    size_t size() const { return active; }
+
+    // Returns a handle for cancel()
+    int schedule(long long key, uint64_t expiresAt)
+    {
+        int node;
+        if (!freeNodes.empty())
+        {
+            node = freeNodes.back();
+            freeNodes.pop_back();
+        }
+        else
+        {
+            node = nodes.size();
+            nodes.push_back(Node());
+        }
+        nodes[node].key = key;
+        nodes[node].expires = max(expiresAt, current + 1);
+        link(node);
+        active++;
+        return node;
+    }
+
+    void cancel(int handle)
+    {
+        unlink(handle);
+        nodes[handle].slot = -1;
+        freeNodes.push_back(handle);
+        active--;
+    }
+
+    // Moves time forward to `now`, appending the keys of due timers to `expired`
+    void advance(uint64_t now, vector<long long> &expired)
+    {
+        if (active == 0)
+        {
+            current = max(current, now); // nothing pending: jump straight there
+            return;
+        }
+        while (current < now && active > 0)
+        {
+            current++;
+            // When a lower level wraps, redistribute the next slot of the level above
+            for (int level = 1; level < LEVELS && (current & ((1ULL << (level * SLOT_BITS)) - 1)) == 0; ++level)
+                cascade(level, (current >> (level * SLOT_BITS)) & (SLOTS - 1));
+            int slot = current & (SLOTS - 1);
+            while (slotHead[slot] != -1)
+            {
+                int node = slotHead[slot];
+                expired.push_back(nodes[node].key);
+                cancel(node);
+            }
+        }
+        current = max(current, now);
+    }
+
+private:
+    struct Node
+    {
+        long long key = 0;
+        uint64_t expires = 0;
+        int slot = -1;
+        int prev = -1, next = -1;
+    };
+    uint64_t current;
+    size_t active;
+    vector<Node> nodes;
+    vector<int> freeNodes;
+    vector<int> slotHead; // level * SLOTS + index -> first node
+
+    void link(int node)
+    {
+        Node &n = nodes[node];
+        uint64_t delta = n.expires - current;
+        int level = 0;
+        while (level < LEVELS - 1 && delta >= ((uint64_t)1 << ((level + 1) * SLOT_BITS)))
+            level++;
+        if (level == LEVELS - 1 && delta >= ((uint64_t)1 << (LEVELS * SLOT_BITS)))
+            n.expires = current + ((uint64_t)1 << (LEVELS * SLOT_BITS)) - 1; // clamp to the wheel's range
+        n.slot = level * SLOTS + ((n.expires >> (level * SLOT_BITS)) & (SLOTS - 1));
+        n.prev = -1;
+        n.next = slotHead[n.slot];
+        if (n.next != -1)
+            nodes[n.next].prev = node;
+        slotHead[n.slot] = node;
+    }
+
+    void unlink(int node)
+    {
+        Node &n = nodes[node];
+        if (n.prev != -1)
+            nodes[n.prev].next = n.next;
+        else
+            slotHead[n.slot] = n.next;
+        if (n.next != -1)
+            nodes[n.next].prev = n.prev;
+    }
+
+    void cascade(int level, int index)
+    {
+        int node = slotHead[level * SLOTS + index];
+        slotHead[level * SLOTS + index] = -1;
+        while (node != -1)
+        {
+            int next = nodes[node].next;
+            link(node);
+            node = next;
+        }
+    }
+};
+
+// ---------------------- Flight Query Engine ----------------------
+// Availability search over any mix of route, departure and arrival windows,
+// free seats and current fare, with sorting and a result limit.
+enum FlightSortKey
+{
+    SORT_DEPARTURE,
+    SORT_ARRIVAL,
+    SORT_PRICE,
+    SORT_DURATION,
+    SORT_SEATS
+};
+
+struct FlightQuery
+{
+    string source, destination; // empty matches any airport
+    int departFrom = numeric_limits<int>::min(), departTo = numeric_limits<int>::max(); // inclusive, minutes
+    int arriveFrom = numeric_limits<int>::min(), arriveTo = numeric_limits<int>::max();
+    int minSeats = 0;
+    double maxPrice = 0; // current fare ceiling, 0 for none
+    FlightSortKey sortBy = SORT_DEPARTURE;
+    bool descending = false;
+    int limit = 0; // 0 returns every match
+};
+
+// One query result with what it was ordered by, so results from several
+// shards merge into the order one system would give
+struct FlightMatch
+{
+    long long key; // ascending; negated for descending queries
+    int departure; // ties keep departure order,
+    int flightID;  // then ID order
+    string line;   // as queryFlights prints it
+
+    bool operator<(const FlightMatch &o) const
+    {
+        if (key != o.key)
+            return key < o.key;
+        return departure != o.departure ? departure < o.departure : flightID < o.flightID;
+    }
+};
+
+// Reads "from=DEL to=BLR dep=480-720 arr=600-900 seats=2 maxprice=6000
+// sort=price desc limit=5", every term optional; false on a bad term
+bool parseFlightQuery(istream &in, FlightQuery &q)
+{
+    const char *SORT_NAMES[] = {"departure", "arrival", "price", "duration", "seats"};
+    string term;
+    while (in >> term)
+    {
+        if (term == "desc")
+        {
+            q.descending = true;
+            continue;
+        }
+        size_t eq = term.find('=');
+        if (eq == string::npos)
+            return false;
+        string key = term.substr(0, eq), value = term.substr(eq + 1);
+        size_t dash = value.find('-', 1);
+        if (key == "from")
+            q.source = value;
+        else if (key == "to")
+            q.destination = value;
+        else if ((key == "dep" || key == "arr") && dash != string::npos)
+        {
+            int lo = atoi(value.substr(0, dash).c_str()), hi = atoi(value.substr(dash + 1).c_str());
+            (key == "dep" ? q.departFrom : q.arriveFrom) = lo;
+            (key == "dep" ? q.departTo : q.arriveTo) = hi;
+        }
+        else if (key == "seats")
+            q.minSeats = atoi(value.c_str());
+        else if (key == "maxprice")
+            q.maxPrice = atof(value.c_str());
+        else if (key == "limit")
+            q.limit = atoi(value.c_str());
+        else if (key == "sort")
+        {
+            int k = 0;
+            while (k < 5 && value != SORT_NAMES[k])
+                ++k;
+            if (k == 5)
+                return false;
+            q.sortBy = (FlightSortKey)k;
+        }
+        else
+            return false;
+    }
+    return true;
+}
+
+// ---------------------- Call Capture ----------------------
+// Compact binary log of AirlinesSystem calls, replayed with --replay. The
+// file starts with "FECALLS1"; each record is a call code (1 byte), the
+// microseconds since the previous record and the call's arguments.
+// Integers are zigzag varints, strings and lists are length-prefixed and
+// prices are raw little-endian doubles, so a typical record is 5-20 bytes.
+// Codes are part of the format: append new ones, never renumber.
+enum CallCode
+{
+    CALL_REGISTER = 1,
+    CALL_ADD_FLIGHT,
+    CALL_REMOVE_FLIGHT,
+    CALL_UPDATE_FLIGHT,
+    CALL_LIST_FLIGHTS,
+    CALL_SET_LOCATION,
+    CALL_ADD_CREW,
+    CALL_ASSIGN_CREW,
+    CALL_LIST_CREW,
+    CALL_CREW_VACANCY,
+    CALL_SEARCH,
+    CALL_SEARCH_TIME,
+    CALL_BOOK,
+    CALL_CANCEL,
+    CALL_BOOK_GROUP,
+    CALL_HOLD,
+    CALL_CONFIRM_HOLD,
+    CALL_RELEASE_HOLD,
+    CALL_SET_HOLD_TTL,
+    CALL_LIST_BOOKINGS,
+    CALL_SHORTEST_ROUTE,
+    CALL_CHEAPEST_ROUTE,
+    CALL_BOOK_ITINERARY,
+    CALL_BOOK_ROUTE,
+    CALL_REACHABLE,
+    CALL_BATCH_ROUTES,
+    CALL_OCCUPANCY_REPORT,
+    CALL_WAITLIST_REPORT,
+    CALL_PRINT_DUTIES,
+    CALL_ROUTE_INDEX,
+    CALL_DISTANCE_TABLE,
+    CALL_QUALIFY_CREW,
+    CALL_CREW_REQUIREMENTS,
+    CALL_QUERY_FLIGHTS,
+    CALL_DELAY_FLIGHT,
+    CALL_CODE_END
+};
+
+const char *CALL_NAMES[CALL_CODE_END] = {
+    "", "registerPassenger", "addFlight", "removeFlight", "updateFlight", "listFlights",
+    "setAirportLocation", "addCrew", "assignCrewToAllFlights", "listCrew", "checkCrewVacancy",
+    "searchFlights", "searchFlightsByTime", "bookFlight", "cancelBooking", "bookGroup", "holdSeat",
+    "confirmHold", "releaseHold", "setHoldTtl", "listPassengerBookings", "findShortestRoute",
+    "findCheapestRoute", "bookItinerary", "bookRoute", "reachableFrom", "batchRoutes",
+    "flightOccupancyReport", "waitlistReport", "printAllDuties", "setRouteIndexEnabled",
+    "setDistanceTableEnabled", "qualifyCrew", "setCrewRequirements", "queryFlights", "delayFlight"};
+
+const char CALL_LOG_MAGIC[] = "FECALLS1";
+
+class CallWriter
+{
+public:
+    bool open(const string &path)
+    {
+        file.open(path.c_str(), ios::binary | ios::trunc);
+        if (!file)
+            return false;
+        file.write(CALL_LOG_MAGIC, 8);
+        last = lastFlush = chrono::steady_clock::now();
+        return true;
+    }
+
+    template <typename... Args>
+    void record(CallCode code, const Args &...args)
+    {
+        chrono::steady_clock::time_point now = chrono::steady_clock::now();
+        pending.clear();
+        pending.push_back((char)code);
+        putVarint(chrono::duration_cast<chrono::microseconds>(now - last).count());
+        last = now;
+        (put(args), ...);
+        file.write(pending.data(), pending.size());
+        // At most a second of calls is lost if the process is killed
+        if (now - lastFlush >= chrono::seconds(1))
+        {
+            file.flush();
+            lastFlush = now;
+        }
+    }
+
+private:
+    ofstream file;
+    string pending;
+    chrono::steady_clock::time_point last, lastFlush;
+
+    void putVarint(uint64_t v)
+    {
+        while (v >= 0x80)
+        {
+            pending.push_back((char)(v | 0x80));
+            v >>= 7;
+        }
+        pending.push_back((char)v);
+    }
+    void put(long long v) { putVarint(((uint64_t)v << 1) ^ (uint64_t)(v >> 63)); }
+    void put(int v) { put((long long)v); }
+    void put(bool v) { put((long long)v); }
+    void put(double v)
+    {
+        char raw[sizeof(v)];
+        memcpy(raw, &v, sizeof(v));
+        pending.append(raw, sizeof(v));
+    }
+    void put(const string &v)
+    {
+        putVarint(v.size());
+        pending += v;
+    }
+    void put(const RouteQuery &q)
+    {
+        put(q.src);
+        put(q.dest);
+        put(q.byPrice);
+    }
+    void put(const FlightQuery &q)
+    {
+        put(q.source);
+        put(q.destination);
+        put(q.departFrom);
+        put(q.departTo);
+        put(q.arriveFrom);
+        put(q.arriveTo);
+        put(q.minSeats);
+        put(q.maxPrice);
+        put((int)q.sortBy);
+        put(q.descending);
+        put(q.limit);
+    }
+    template <typename T>
+    void put(const vector<T> &v)
+    {
+        putVarint(v.size());
+        for (size_t i = 0; i < v.size(); ++i)
+            put(v[i]);
+    }
+};
+
+// Reads a capture back; every getter returns a zero value once the data runs out
+class CallReader
+{
+public:
+    bool truncated = false;
+
+    bool open(const string &path)
+    {
+        ifstream file(path.c_str(), ios::binary);
+        if (!file)
+            return false;
+        ostringstream contents;
+        contents << file.rdbuf();
+        data = contents.str();
+        pos = 8;
+        return data.compare(0, 8, CALL_LOG_MAGIC) == 0;
+    }
+
+    bool atEnd() const { return pos >= data.size(); }
+
+    // Next record header; false at the end of the log or on an unknown code
+    bool next(CallCode &code, uint64_t &deltaMicros)
+    {
+        if (pos >= data.size())
+            return false;
+        code = (CallCode)(unsigned char)data[pos++];
+        deltaMicros = getVarint();
+        return code > 0 && code < CALL_CODE_END && !truncated;
+    }
+
+    long long getInt()
+    {
+        uint64_t v = getVarint();
+        return (long long)(v >> 1) ^ -(long long)(v & 1);
+    }
+    double getDouble()
+    {
+        double v = 0;
+        if (!take(sizeof(v)))
+            return 0;
+        memcpy(&v, &data[pos - sizeof(v)], sizeof(v));
+        return v;
+    }
+    string getString()
+    {
+        uint64_t n = getVarint();
+        if (!take(n))
+            return "";
+        return data.substr(pos - n, n);
+    }
+    vector<int> getInts()
+    {
+        vector<int> v(min<uint64_t>(getVarint(), data.size()));
+        for (size_t i = 0; i < v.size(); ++i)
+            v[i] = getInt();
+        return v;
+    }
+    vector<string> getStrings()
+    {
+        vector<string> v(min<uint64_t>(getVarint(), data.size()));
+        for (size_t i = 0; i < v.size(); ++i)
+            v[i] = getString();
+        return v;
+    }
+    vector<RouteQuery> getQueries()
+    {
+        vector<RouteQuery> v;
+        for (uint64_t n = min<uint64_t>(getVarint(), data.size()); n > 0; --n)
+        {
+            string src = getString(), dest = getString();
+            v.push_back(RouteQuery(src, dest, getInt() != 0));
+        }
+        return v;
+    }
+    FlightQuery getFlightQuery()
+    {
+        FlightQuery q;
+        q.source = getString();
+        q.destination = getString();
+        q.departFrom = getInt();
+        q.departTo = getInt();
+        q.arriveFrom = getInt();
+        q.arriveTo = getInt();
+        q.minSeats = getInt();
+        q.maxPrice = getDouble();
+        q.sortBy = (FlightSortKey)getInt();
+        q.descending = getInt() != 0;
+        q.limit = getInt();
+        return q;
+    }
+
+private:
+    string data;
+    size_t pos = 0;
+
+    bool take(uint64_t n)
+    {
+        if (n > data.size() - pos)
+        {
+            truncated = true;
+            pos = data.size();
+            return false;
+        }
+        pos += n;
+        return true;
+    }
+    uint64_t getVarint()
+    {
+        uint64_t v = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            if (!take(1))
+                return 0;
+            unsigned char b = data[pos - 1];
+            v |= (uint64_t)(b & 0x7f) << shift;
+            if (!(b & 0x80))
+                break;
+        }
+        return v;
+    }
+};
+
+// ---------------------- Snapshot Read Views ----------------------
+// Reports read an immutable published version of the schedule instead of
+// the live flights and crew, so a long scan never holds up a booking.
+// Writers copy what they change, swap in the new version with one atomic
+// store and retire the old one; readers take no locks and touch no
+// reference counts. A retired version is freed once every reader that
+// could still hold it has left (epoch-based reclamation).
+
+// Seats, waitlist and fare of a flight at some moment
+struct SeatState
+{
+    int seatsAvailable;
+    int waitlistedPassengers;
+    double price;
+};
+
+// A flight as readers see it: no seat map or bookings, and the waitlist
+// only as party sizes
+struct FlightView
+{
+    int flightID;
+    string source;
+    string destination;
+    int departureTime;
+    int arrivalTime;
+    int seatsTotal;
+    int seatsAvailable;
+    int waitlistedPassengers;
+    double basePrice;
+    double price; // dynamic fare when the view was published
+    vector<int> crewAssigned;
+    vector<uint64_t> holdExpiries; // ascending
+    vector<int> waitlistParties;   // front of the queue first
+
+    explicit FlightView(const Flight &f)
+        : flightID(f.flightID), source(f.source), destination(f.destination),
+          departureTime(f.departureTime), arrivalTime(f.arrivalTime), seatsTotal(f.seatsTotal),
+          seatsAvailable(f.seatsAvailable), waitlistedPassengers(f.waitlistedPassengers),
+          basePrice(f.basePrice), price(dynamicPrice(f)), crewAssigned(f.crewAssigned),
+          holdExpiries(f.holdExpiries)
+    {
+        for (queue<WaitlistEntry> q = f.waitlist; !q.empty(); q.pop())
+            waitlistParties.push_back(q.front().partySize);
+    }
+
+    // Seats as expireHolds will leave them at `now` (ms on the hold clock):
+    // each lapsed hold frees its seat, which goes to the waitlist the way
+    // freeSeat hands it out. Readers use this instead of expiring holds.
+    SeatState seatsAt(uint64_t now) const
+    {
+        SeatState s = {seatsAvailable, waitlistedPassengers, price};
+        if (holdExpiries.empty() || holdExpiries[0] > now)
+            return s;
+        size_t head = 0;
+        for (size_t i = 0; i < holdExpiries.size() && holdExpiries[i] <= now; ++i)
+        {
+            s.seatsAvailable++;
+            while (head < waitlistParties.size() && waitlistParties[head] <= s.seatsAvailable)
+            {
+                s.seatsAvailable -= waitlistParties[head];
+                s.waitlistedPassengers -= waitlistParties[head++];
+            }
+        }
+        s.price = dynamicPrice(basePrice, seatsTotal, s.seatsAvailable);
+        return s;
+    }
+};
+
+struct CrewView
+{
+    int id;
+    string name;
+    CrewRole role;
+    vector<int> flights; // assigned flight IDs, ascending
+};
+
+class FlightColumns;
+
+// Flights in ID order as a two-level tree: groups of 64 chunks of 64
+// views. A new version copies only the path to each flight it changes (one
+// group, one chunk, the view) and shares every other node with the version
+// before it. Published nodes are never written again, except that the
+// first query on a version attaches its columns.
+class ScheduleSnapshot
+{
+public:
+    static const size_t CHUNK = 64, GROUP = CHUNK * CHUNK;
+
+    ScheduleSnapshot() {}
+
+    size_t size() const { return count; }
+    const FlightView &flight(size_t i) const { return *chunk(i).views[i % CHUNK]; }
+
+    // FlightView::seatsAt for flight i, answered from the copies packed in
+    // its chunk unless a hold there has lapsed
+    void seatsAndFare(size_t i, uint64_t now, int &seats, int &fareCents) const
+    {
+        const Chunk &c = chunk(i);
+        if (c.earliestHold > now)
+        {
+            seats = c.seats[i % CHUNK];
+            fareCents = c.fares[i % CHUNK];
+            return;
+        }
+        SeatState s = c.views[i % CHUNK]->seatsAt(now);
+        seats = s.seatsAvailable;
+        fareCents = fareInCents(s.price);
+    }
+    const vector<CrewView> &crew() const { return *crewViews; }
+
+    const FlightView *find(int flightID) const
+    {
+        size_t left = 0, right = count;
+        while (left < right)
+        {
+            size_t mid = left + (right - left) / 2;
+            if (flight(mid).flightID < flightID)
+                left = mid + 1;
+            else
+                right = mid;
+        }
+        return left < count && flight(left).flightID == flightID ? &flight(left) : NULL;
+    }
+
+    long long seatsSold() const
+    {
+        long long sold = 0;
+        for (size_t i = 0; i < count; ++i)
+            sold += flight(i).seatsTotal - flight(i).seatsAvailable;
+        return sold;
+    }
+
+    // Query columns for this version's layout, built by the first reader
+    // that needs them unless an earlier version with the same layout has them
+    const FlightColumns &queryColumns() const;
+
+private:
+    friend class ScheduleVersions;
+    // `version` marks nodes made for the draft, which may still be edited in place
+    struct Chunk
+    {
+        const FlightView *views[CHUNK] = {};
+        int seats[CHUNK] = {}, fares[CHUNK] = {}; // packed for queries
+        uint64_t earliestHold = ~0ULL;             // soonest hold expiry in the chunk
+        uint64_t version = 0;
+    };
+    struct Group
+    {
+        Chunk *chunks[CHUNK] = {};
+        uint64_t version = 0;
+    };
+    vector<Group *> groups;
+    size_t count = 0;
+    const vector<CrewView> *crewViews = NULL;
+    uint64_t version = 0;
+    uint64_t layout = 0; // version that last added, removed, retimed or rerouted a flight
+    mutable atomic<const FlightColumns *> columns{NULL};
+
+    const Chunk &chunk(size_t i) const { return *groups[i / GROUP]->chunks[i / CHUNK % CHUNK]; }
+
+    // For the next draft; the columns are handed over at publish
+    ScheduleSnapshot(const ScheduleSnapshot &o)
+        : groups(o.groups), count(o.count), crewViews(o.crewViews), version(o.version), layout(o.layout) {}
+};
+
+// One layout's flights as packed int columns ordered by departure time, so
+// a departure window is one contiguous slice, plus hash indexes on route and
+// source. Bookings leave the layout alone, so versions share the columns
+// until a flight is added, removed, retimed or rerouted; seats and fares
+// come from the views of the version being queried. select() plans each
+// query against whichever of those yields the fewest candidates and checks
+// the time and route predicates four rows at a time with vector extensions.
+class FlightColumns
+{
+public:
+    explicit FlightColumns(const ScheduleSnapshot &s)
+    {
+        int n = s.size();
+        order.resize(n);
+        for (int i = 0; i < n; ++i)
+            order[i] = i;
+        stable_sort(order.begin(), order.end(), [&](int a, int b)
+                    { return s.flight(a).departureTime < s.flight(b).departureTime; });
+        dep.resize(n);
+        arr.resize(n);
+        src.resize(n);
+        dst.resize(n);
+        for (int r = 0; r < n; ++r)
+        {
+            const FlightView &f = s.flight(order[r]);
+            dep[r] = f.departureTime;
+            arr[r] = f.arrivalTime;
+            src[r] = airportID(f.source);
+            dst[r] = airportID(f.destination);
+            byRoute[routeKey(src[r], dst[r])].push_back(r);
+            bySource[src[r]].push_back(r);
+        }
+    }
+
+    // Rows of s matching q in departure order, seats and fares as of `now`;
+    // plan describes the access path
+    void select(const FlightQuery &q, const ScheduleSnapshot &s, uint64_t now, pmr::vector<int> &rows, pmr::string &plan) const
+    {
+        rows.clear();
+        Predicate p;
+        p.arrLo = q.arriveFrom;
+        p.arrHi = q.arriveTo;
+        p.depLo = q.departFrom;
+        p.depHi = q.departTo;
+        p.src = q.source.empty() ? -1 : findAirport(q.source);
+        p.dst = q.destination.empty() ? -1 : findAirport(q.destination);
+        if ((!q.source.empty() && p.src == -1) || (!q.destination.empty() && p.dst == -1))
+        {
+            plan = "unknown airport, nothing to scan";
+            return;
+        }
+
+        // Departure slice [lo, hi) of the sorted column
+        int lo = lower_bound(dep.begin(), dep.end(), q.departFrom) - dep.begin();
+        int hi = upper_bound(dep.begin(), dep.end(), q.departTo) - dep.begin();
+        hi = max(lo, hi);
+        const vector<int> *index = NULL;
+        if (p.src != -1 && p.dst != -1)
+        {
+            index = lookup(byRoute, routeKey(p.src, p.dst));
+            plan = "route index";
+        }
+        else if (p.src != -1)
+        {
+            index = lookup(bySource, p.src);
+            plan = "source index";
+        }
+
+        if (index && (int)index->size() <= hi - lo)
+        {
+            for (size_t i = 0; i < index->size(); ++i)
+            {
+                int r = (*index)[i];
+                rows.push_back(r);
+                rows.resize(rows.size() - !p.matches(*this, r)); // no branch on the predicate
+            }
+            plan += " (" + to_string(index->size()) + (index->size() == 1 ? " candidate)" : " candidates)");
+        }
+        else
+        {
+            plan = hi - lo == (int)dep.size() ? "full scan" : "departure range";
+            plan += " (" + to_string(hi - lo) + (hi - lo == 1 ? " row)" : " rows)");
+            scan(p, lo, hi, rows);
+        }
+
+        if (q.minSeats <= 0 && q.maxPrice <= 0)
+            return;
+        int maxFare = q.maxPrice > 0 ? (int)min(floor(q.maxPrice * 100), (double)numeric_limits<int>::max()) : numeric_limits<int>::max();
+        size_t kept = 0;
+        for (size_t i = 0; i < rows.size(); ++i)
+        {
+            int seats, fare;
+            s.seatsAndFare(order[rows[i]], now, seats, fare);
+            rows[kept] = rows[i];
+            kept += (seats >= q.minSeats) & (fare <= maxFare);
+        }
+        rows.resize(kept);
+    }
+
+    int flightIndex(int row) const { return order[row]; }
+    int departure(int row) const { return dep[row]; }
+    int arrival(int row) const { return arr[row]; }
+
+private:
+    vector<int> order; // row -> flight index
+    vector<int> dep, arr, src, dst;
+    unordered_map<string, int> airports; // codes numbered for src and dst
+    unordered_map<long long, vector<int>> byRoute;
+    unordered_map<long long, vector<int>> bySource;
+
+    struct Predicate
+    {
+        int depLo, depHi, arrLo, arrHi, src, dst; // src/dst -1 for any
+
+        bool matches(const FlightColumns &c, int r) const
+        {
+            return (c.dep[r] >= depLo) & (c.dep[r] <= depHi) & (c.arr[r] >= arrLo) & (c.arr[r] <= arrHi) &
+                   ((src == -1) | (c.src[r] == src)) & ((dst == -1) | (c.dst[r] == dst));
+        }
+    };
+
+    int airportID(const string &code)
+    {
+        return airports.emplace(code, (int)airports.size()).first->second;
+    }
+
+    int findAirport(const string &code) const
+    {
+        unordered_map<string, int>::const_iterator it = airports.find(code);
+        return it == airports.end() ? -1 : it->second;
+    }
+
+    static long long routeKey(int s, int d) { return ((long long)s << 32) | (unsigned)d; }
+
+    static const vector<int> *lookup(const unordered_map<long long, vector<int>> &m, long long key)
+    {
+        static const vector<int> none;
+        unordered_map<long long, vector<int>>::const_iterator it = m.find(key);
+        return it == m.end() ? &none : &it->second;
+    }
+
+    // Residual predicates over a departure slice, which already satisfies the window
+    void scan(const Predicate &p, int lo, int hi, pmr::vector<int> &rows) const
+    {
+        int r = lo;
+#if defined(__GNUC__)
+        typedef int Lanes __attribute__((vector_size(16)));
+        Lanes arrLo = {p.arrLo, p.arrLo, p.arrLo, p.arrLo}, arrHi = {p.arrHi, p.arrHi, p.arrHi, p.arrHi};
+        Lanes wantSrc = {p.src, p.src, p.src, p.src}, wantDst = {p.dst, p.dst, p.dst, p.dst};
+        Lanes anySrc = wantSrc == -1, anyDst = wantDst == -1; // all ones when unconstrained
+        for (; r + 4 <= hi; r += 4)
+        {
+            Lanes a, so, de;
+            memcpy(&a, &arr[r], sizeof(a));
+            memcpy(&so, &src[r], sizeof(so));
+            memcpy(&de, &dst[r], sizeof(de));
+            Lanes hit = (a >= arrLo) & (a <= arrHi) & (anySrc | (so == wantSrc)) & (anyDst | (de == wantDst));
+            if (!(hit[0] | hit[1] | hit[2] | hit[3]))
+                continue;
+            for (int k = 0; k < 4; ++k)
+                if (hit[k])
+                    rows.push_back(r + k);
+        }
+#endif
+        for (; r < hi; ++r)
+            if (p.matches(*this, r))
+                rows.push_back(r);
+    }
+};
+
+const FlightColumns &ScheduleSnapshot::queryColumns() const
+{
+    const FlightColumns *c = columns.load(memory_order_acquire);
+    if (c)
+        return *c;
+    FlightColumns *built = new FlightColumns(*this);
+    if (columns.compare_exchange_strong(c, built, memory_order_acq_rel))
+        return *built;
+    delete built; // another reader got there first
+    return *c;
+}
+
+// Global epoch plus one announcement slot per thread. A reader stores the
+// epoch it entered in; a version retired at epoch e is unreachable once
+// every announced epoch is above e.
+class EpochDomain
+{
+public:
+    static EpochDomain &instance()
+    {
+        static EpochDomain domain;
+        return domain;
+    }
+
+    // Nests; only the outermost enter announces
+    void enter()
+    {
+        Slot &s = local();
+        if (s.depth++ == 0)
+            s.active.store(epoch.load());
+    }
+
+    void leave()
+    {
+        Slot &s = local();
+        if (--s.depth == 0)
+            s.active.store(IDLE);
+    }
+
+    // Starts a new epoch and returns the one it ends
+    uint64_t advance() { return epoch.fetch_add(1); }
+
+    uint64_t oldestActive()
+    {
+        lock_guard<mutex> guard(lock);
+        uint64_t oldest = IDLE;
+        for (size_t i = 0; i < slots.size(); ++i)
+            oldest = min(oldest, slots[i]->active.load());
+        return oldest;
+    }
+
+private:
+    static const uint64_t IDLE = ~0ULL;
+    struct Slot
+    {
+        atomic<uint64_t> active{IDLE};
+        int depth = 0;
+    };
+    atomic<uint64_t> epoch{1};
+    mutex lock;
+    vector<unique_ptr<Slot>> slots;
+
+    // Slots outlive their threads, like the metrics slabs
+    Slot &local()
+    {
+        static thread_local Slot *mine = NULL;
+        if (!mine)
+        {
+            lock_guard<mutex> guard(lock);
+            slots.push_back(unique_ptr<Slot>(new Slot()));
+            mine = slots.back().get();
+        }
+        return *mine;
+    }
+};
+
+// The published version, the draft of the next one and the retired ones
+// still waiting for readers. The nodes a draft replaces are retired with
+// the version it replaces: no later version can reach them. Writer-side
+// calls are for one thread at a time; the caller serialises them.
+class ScheduleVersions
+{
+public:
+    ScheduleVersions()
+    {
+        ScheduleSnapshot *first = new ScheduleSnapshot();
+        first->crewViews = new vector<CrewView>();
+        current.store(first);
+    }
+
+    ~ScheduleVersions()
+    {
+        publish();
+        for (size_t i = 0; i < retired.size(); ++i)
+            release(retired[i]);
+        const ScheduleSnapshot *last = current.load();
+        delete last->columns.load();
+        for (size_t g = 0; g < last->groups.size(); ++g)
+        {
+            for (size_t c = 0; c < ScheduleSnapshot::CHUNK; ++c)
+            {
+                ScheduleSnapshot::Chunk *chunk = last->groups[g]->chunks[c];
+                if (!chunk)
+                    continue;
+                for (size_t v = 0; v < ScheduleSnapshot::CHUNK; ++v)
+                    delete chunk->views[v];
+                delete chunk;
+            }
+            delete last->groups[g];
+        }
+        delete last->crewViews;
+        delete last;
+    }
+
+    const ScheduleSnapshot *latest() const { return current.load(); }
+
+    void setFlight(size_t i, const Flight &f)
+    {
+        ScheduleSnapshot &d = draft();
+        ScheduleSnapshot::Group *&group = d.groups[i / ScheduleSnapshot::GROUP];
+        if (group->version != d.version)
+        {
+            garbage.groups.push_back(group);
+            group = new ScheduleSnapshot::Group(*group);
+            group->version = d.version;
+        }
+        ScheduleSnapshot::Chunk *&chunk = group->chunks[i / ScheduleSnapshot::CHUNK % ScheduleSnapshot::CHUNK];
+        if (!chunk || chunk->version != d.version)
+        {
+            if (chunk)
+                garbage.chunks.push_back(chunk);
+            chunk = chunk ? new ScheduleSnapshot::Chunk(*chunk) : new ScheduleSnapshot::Chunk();
+            chunk->version = d.version;
+        }
+        const FlightView *&view = chunk->views[i % ScheduleSnapshot::CHUNK];
+        if (!view || view->departureTime != f.departureTime || view->arrivalTime != f.arrivalTime ||
+            view->source != f.source || view->destination != f.destination)
+            d.layout = d.version;
+        if (view)
+            garbage.views.push_back(view);
+        view = new FlightView(f);
+        chunk->seats[i % ScheduleSnapshot::CHUNK] = f.seatsAvailable;
+        chunk->fares[i % ScheduleSnapshot::CHUNK] = fareInCents(view->price);
+        chunk->earliestHold = ~0ULL;
+        for (size_t v = 0; v < ScheduleSnapshot::CHUNK; ++v)
+            if (chunk->views[v] && !chunk->views[v]->holdExpiries.empty())
+                chunk->earliestHold = min(chunk->earliestHold, chunk->views[v]->holdExpiries[0]);
+    }
+
+    void appendFlight(const Flight &f)
+    {
+        ScheduleSnapshot &d = draft();
+        if (d.count % ScheduleSnapshot::GROUP == 0)
+        {
+            d.groups.push_back(new ScheduleSnapshot::Group());
+            d.groups.back()->version = d.version;
+        }
+        setFlight(d.count++, f);
+    }
+
+    // After flights were removed or reordered; replaces every node
+    void assignFlights(const vector<Flight> &flights)
+    {
+        ScheduleSnapshot &d = draft();
+        for (size_t g = 0; g < d.groups.size(); ++g)
+        {
+            for (size_t c = 0; c < ScheduleSnapshot::CHUNK; ++c)
+            {
+                ScheduleSnapshot::Chunk *chunk = d.groups[g]->chunks[c];
+                if (!chunk)
+                    continue;
+                for (size_t v = 0; v < ScheduleSnapshot::CHUNK; ++v)
+                    if (chunk->views[v])
+                        garbage.views.push_back(chunk->views[v]);
+                garbage.chunks.push_back(chunk);
+            }
+            garbage.groups.push_back(d.groups[g]);
+        }
+        d.groups.clear();
+        d.count = 0;
+        d.layout = d.version;
+        for (size_t i = 0; i < flights.size(); ++i)
+            appendFlight(flights[i]);
+    }
+
+    void setCrew(const unordered_map<int, CrewMember> &crew)
+    {
+        ScheduleSnapshot &d = draft();
+        vector<CrewView> *views = new vector<CrewView>();
+        for (unordered_map<int, CrewMember>::const_iterator it = crew.begin(); it != crew.end(); ++it)
+        {
+            const CrewMember &c = it->second;
+            views->push_back(CrewView{c.id, c.name, c.role, vector<int>(c.assignedFlights.begin(), c.assignedFlights.end())});
+        }
+        garbage.crews.push_back(d.crewViews);
+        d.crewViews = views;
+    }
+
+    // Makes the draft the current version; a no-op when nothing changed
+    void publish()
+    {
+        if (!next)
+            return;
+        const ScheduleSnapshot *last = current.load();
+        if (next->layout == last->layout)
+            next->columns.store(last->columns.load(memory_order_acquire));
+        garbage.successor = next;
+        garbage.snapshot = current.exchange(next);
+        garbage.epoch = EpochDomain::instance().advance();
+        next = NULL;
+        retired.push_back(Garbage());
+        swap(retired.back(), garbage);
+
+        uint64_t oldest = EpochDomain::instance().oldestActive();
+        size_t kept = 0;
+        for (size_t i = 0; i < retired.size(); ++i)
+        {
+            if (retired[i].epoch < oldest)
+                release(retired[i]);
+            else
+                swap(retired[kept++], retired[i]);
+        }
+        retired.resize(kept);
+    }
+
+private:
+    // A retired version with the nodes its successor stopped using
+    struct Garbage
+    {
+        const ScheduleSnapshot *snapshot = NULL;
+        const ScheduleSnapshot *successor = NULL; // still current or retired later
+        uint64_t epoch = 0;
+        vector<const FlightView *> views;
+        vector<ScheduleSnapshot::Chunk *> chunks;
+        vector<ScheduleSnapshot::Group *> groups;
+        vector<const vector<CrewView> *> crews;
+    };
+    atomic<const ScheduleSnapshot *> current;
+    ScheduleSnapshot *next = NULL;
+    uint64_t lastVersion = 0;
+    Garbage garbage; // collected for the draft
+    vector<Garbage> retired;
+
+    ScheduleSnapshot &draft()
+    {
+        if (!next)
+        {
+            next = new ScheduleSnapshot(*current.load());
+            next->version = ++lastVersion;
+        }
+        return *next;
+    }
+
+    static void release(Garbage &g)
+    {
+        for (size_t i = 0; i < g.views.size(); ++i)
+            delete g.views[i];
+        for (size_t i = 0; i < g.chunks.size(); ++i)
+            delete g.chunks[i];
+        for (size_t i = 0; i < g.groups.size(); ++i)
+            delete g.groups[i];
+        for (size_t i = 0; i < g.crews.size(); ++i)
+            delete g.crews[i];
+        // Columns pass to the successor when it has the same layout; a
+        // reader may also have built them after it was published
+        const FlightColumns *columns = g.snapshot->columns.load();
+        if (columns != g.successor->columns.load())
+            delete columns;
+        delete g.snapshot;
+        g = Garbage();
+    }
+};
+
+// A reader's hold on one version: it stays valid, and unchanged, until the
+// view goes out of scope. Keep views short so retired versions can go.
+class ScheduleView
+{
+public:
+    explicit ScheduleView(const ScheduleVersions &versions)
+    {
+        EpochDomain::instance().enter();
+        snapshot = versions.latest();
+    }
+    ~ScheduleView() { EpochDomain::instance().leave(); }
+    // A copy would leave the epoch twice
+    ScheduleView(const ScheduleView &) = delete;
+    ScheduleView &operator=(const ScheduleView &) = delete;
+
+    const ScheduleSnapshot *operator->() const { return snapshot; }
+    const ScheduleSnapshot &operator*() const { return *snapshot; }
+
+private:
+    const ScheduleSnapshot *snapshot;
+};
+
+// ---------------------- Main System Class ----------------------
+class AirlinesSystem
+{
+private:
+    ostream &out; // where operations report; cout unless a shard gets its own stream
+    vector<Flight> flights;
+    unordered_map<string, Passenger> passengers;
+    unordered_map<string, Admin> admins;
+    unordered_map<int, CrewMember> crew;
+    CrewRoster roster;                 // packed roles and qualifications of `crew`
+    vector<string> qualificationNames; // bit i of a qualification mask
+    AirportGraph airportGraph;
+    RouteIndexBuilder routeIndex;
+    bool routeIndexEnabled = false;
+    DistanceTableBuilder distanceTables;
+    bool distanceTableEnabled = false;
+    pair<long long, size_t> distanceTableRequested{-1, 0}; // graph version and airport count last queued
+    unique_ptr<WorkStealingPool> queryPool;
+    vector<ReachableAirport> reachable; // reused by reachableFrom
+    RouteResult plannedRoute;           // reused by the single-route operations
+    unordered_map<long long, SeatHold> holds;
+    TimingWheel holdTimers;
+    vector<long long> expiredHolds;
+    long long nextHoldID = 1;
+    int holdTtlSeconds = 600;
+    mutex passengerLock; // guards Passenger::bookings during concurrent itinerary bookings
+    ScheduleVersions versions; // what reports read; see readView()
+    mutex publishLock;         // one snapshot publisher at a time
+    long long pinnedClock = -1; // hold clock in ms when driven by a replay
+    unique_ptr<CallWriter> callLog;
+    long long indexedQueries = 0, fallbackQueries = 0;
+    long long tableFallbackQueries = 0; // searched directly while the all-pairs table was rebuilt
+    double indexedQueryMicros = 0;
+    int nextFlightID = 1000;
+    int flightIDStride = 1; // shards interleave their flight IDs
+    bool recordMetrics = true; // read by METRIC_SCOPE
+    int nextCrewID = 1;
+
+    // --- Helper Functions ---
+    // The all-pairs table while it matches the schedule. Otherwise queues a
+    // background rebuild and returns NULL, so the query searches directly.
+    shared_ptr<const DistanceTable> currentDistanceTable()
+    {
+        if (!distanceTableEnabled)
+            return NULL;
+        shared_ptr<const DistanceTable> table = distanceTables.current();
+        if (table && table->current(airportGraph))
+            return table->n > 0 ? table : NULL;
+        pair<long long, size_t> wanted(airportGraph.version, airportGraph.airportCodes.size());
+        if (distanceTableRequested != wanted)
+        {
+            distanceTables.requestRebuild(airportGraph);
+            distanceTableRequested = wanted;
+        }
+        return NULL;
+    }
+
+    uint64_t nowMillis() const
+    {
+        if (pinnedClock >= 0)
+            return pinnedClock;
+        return chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    template <typename... Args>
+    void logCall(CallCode code, const Args &...args)
+    {
+        if (callLog)
+            callLog->record(code, args...);
+    }
+
+    // Publishes the changed flights (and the crew, if asked) as one new
+    // version, so a reader sees all of the change or none of it. Itinerary
+    // bookings call this with their legs still locked.
+    void publish(Flight *const *changed, size_t n, bool crewChanged = false)
+    {
+        lock_guard<mutex> guard(publishLock);
+        for (size_t i = 0; i < n; ++i)
+            versions.setFlight(changed[i] - flights.data(), *changed[i]);
+        if (crewChanged)
+            versions.setCrew(crew);
+        versions.publish();
+    }
+
+    void publish(Flight &f)
+    {
+        Flight *changed = &f;
+        publish(&changed, 1);
+    }
+
+    // After flights were added or removed, or reordered
+    void publishSchedule()
+    {
+        lock_guard<mutex> guard(publishLock);
+        versions.assignFlights(flights);
+        versions.publish();
+    }
+
+    // Returns seats of lapsed holds to their flights. Called at the start of
+    // every operation that changes seats or reads the live flights; snapshot
+    // readers see lapsed holds through FlightView::seatsAt instead.
+    void expireHolds()
+    {
+        expiredHolds.clear();
+        holdTimers.advance(nowMillis(), expiredHolds);
+        for (size_t i = 0; i < expiredHolds.size(); ++i)
+        {
+            unordered_map<long long, SeatHold>::iterator it = holds.find(expiredHolds[i]);
+            if (it == holds.end())
+                continue;
+            SeatHold h = it->second;
+            holds.erase(it);
+            int idx = binarySearchFlight(h.flightID);
+            if (idx == -1)
+                continue;
+            dropHoldExpiry(flights[idx], h.expiresAt);
+            freeSeat(flights[idx], h.seatNo);
+        }
+    }
+
+    void dropHoldExpiry(Flight &f, uint64_t expiresAt)
+    {
+        vector<uint64_t>::iterator it = lower_bound(f.holdExpiries.begin(), f.holdExpiries.end(), expiresAt);
+        if (it != f.holdExpiries.end() && *it == expiresAt)
+            f.holdExpiries.erase(it);
+    }
+
+    // Puts a seat back into the allocator and offers it to the waitlist
+    void freeSeat(Flight &f, int seatNo)
+    {
+        if (seatNo < 1 || seatNo > f.seatsTotal || !f.seatMap[seatNo - 1])
+            return;
+        f.seatMap[seatNo - 1] = false;
+        f.seatsAvailable++;
+        // Strict FIFO: a party at the head waits until it fits, later entries do not jump it
+        while (!f.waitlist.empty() && f.waitlist.front().partySize <= f.seatsAvailable)
+        {
+            WaitlistEntry next = f.waitlist.front();
+            f.waitlist.pop();
+            f.waitlistedPassengers -= next.partySize;
+            vector<int> seats;
+            allocateSeats(f, next.partySize, seats);
+            for (size_t i = 0; i < seats.size(); ++i)
+            {
+                f.bookings.push_back(Booking(next.username, seats[i]));
+                passengers[next.username].bookings.push_back(f.flightID);
+            }
+            out << "Waitlisted " << (next.partySize > 1 ? "party of " + to_string(next.partySize) + " for " : "passenger ")
+                << next.username << " booked on flight " << f.flightID << ", seat #" << seats[0];
+            if (seats.size() > 1)
+                out << (seats.back() - seats[0] + 1 == (int)seats.size() ? "-" : "...") << seats.back();
+            out << endl;
+        }
+        publish(f);
+    }
+
+    // Reserves n seats in one pass over seatMap: the first run of n adjacent
+    // free seats if there is one, otherwise the first n free seats. The
+    // caller guarantees n <= seatsAvailable. Returns true when adjacent.
+    bool allocateSeats(Flight &f, int n, vector<int> &seats)
+    {
+        seats.clear();
+        int runStart = 0, runLength = 0;
+        for (int i = 0; i < f.seatsTotal; ++i)
+        {
+            if (f.seatMap[i])
+            {
+                runLength = 0;
+                continue;
+            }
+            if (runLength++ == 0)
+                runStart = i;
+            if ((int)seats.size() < n)
+                seats.push_back(i + 1);
+            if (runLength == n)
+            {
+                seats.clear();
+                for (int k = 0; k < n; ++k)
+                    seats.push_back(runStart + k + 1);
+                break;
+            }
+        }
+        for (size_t k = 0; k < seats.size(); ++k)
+            f.seatMap[seats[k] - 1] = true;
+        f.seatsAvailable -= seats.size();
+        return runLength == n;
+    }
+
+    // Route with the flight behind each leg, from whichever engine is active.
+    // Fills r in place, so a reused result keeps its buffers.
+    void planRoute(const string &src, const string &dest, bool byPrice, RouteSearchMode mode, RouteResult &r)
+    {
+        r.cost = -1;
+        r.path.clear();
+        r.flights.clear();
+        // Serve from the shortcut index only while it matches the live schedule
+        shared_ptr<const ContractionHierarchy> index = routeIndexEnabled && !byPrice ? routeIndex.current() : NULL;
+        shared_ptr<const DistanceTable> table = currentDistanceTable();
+        if (table)
+        {
+            r.cost = table->route(airportGraph, byPrice, src, dest, r.path);
+        }
+        else if (byPrice)
+        {
+            r.cost = airportGraph.cheapestRoute(src, dest, r.path, mode);
+        }
+        else if (index && index->version == airportGraph.version)
+        {
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            r.cost = index->shortestRoute(src, dest, r.path);
+            indexedQueryMicros += chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+            indexedQueries++;
+        }
+        else
+        {
+            r.cost = airportGraph.shortestRoute(src, dest, r.path, mode);
+            if (routeIndexEnabled)
+                fallbackQueries++;
+        }
+        if (!table && distanceTableEnabled)
+            tableFallbackQueries++;
+        if (r.cost != -1)
+            airportGraph.legFlights(r.path, byPrice, r.flights);
+    }
+
+    // bookItinerary without the call log, shared with bookRoute. Expires
+    // holds outside the per-flight locks, so like every other writer it must
+    // not run while reserveItinerary is called from other threads.
+    bool bookLegs(const string &username, const vector<int> &legs)
+    {
+        expireHolds();
+        vector<int> seats;
+        int fullFlight = -1, missedFlight = -1;
+        double total = 0;
+        if (!reserveItinerary(username, legs, seats, &fullFlight, &missedFlight))
+        {
+            if (fullFlight != -1)
+                out << "Flight " << fullFlight << " is full. Nothing was booked.\n";
+            else if (missedFlight != -1)
+                out << "Flight " << missedFlight << " does not leave from the previous leg's destination at least "
+                    << MIN_CONNECTION_MINUTES << " minutes after it lands. Nothing was booked.\n";
+            else
+                out << "Invalid itinerary. Nothing was booked.\n";
+            return false;
+        }
+        out << "Itinerary booked (" << legs.size() << " leg" << (legs.size() > 1 ? "s" : "") << "):\n";
+        for (size_t i = 0; i < legs.size(); ++i)
+        {
+            const Flight &f = flights[binarySearchFlight(legs[i])];
+            total += dynamicPrice(f);
+            out << "  Flight " << f.flightID << " | " << f.source << "->" << f.destination
+                << " | Dep: " << minutesToTime(f.departureTime) << " | Seat #" << seats[i] << endl;
+        }
+        out << "Total price: " << total << endl;
+        return true;
+    }
+
+    // Runs q against one version's columns, with holds lapsed by `now`
+    // counted as free, and leaves the first N matching rows, in the order q
+    // asks for, at the front of rows; returns N
+    size_t selectRows(const FlightQuery &q, const ScheduleSnapshot &s, uint64_t now, pmr::vector<int> &rows, pmr::string &plan) const
+    {
+        const FlightColumns &c = s.queryColumns();
+        c.select(q, s, now, rows, plan);
+
+        // Rows come out in departure order; anything else needs a sort
+        size_t keep = q.limit > 0 ? min<size_t>(q.limit, rows.size()) : rows.size();
+        if (q.sortBy == SORT_DEPARTURE && !q.descending)
+            return keep;
+        pmr::vector<pair<long long, int>> keyed(rows.get_allocator());
+        for (size_t i = 0; i < rows.size(); ++i)
+            keyed.push_back(make_pair(sortKey(q, s, c, rows[i], now), rows[i]));
+        // Ties stay in departure order whichever way the key runs
+        partial_sort(keyed.begin(), keyed.begin() + keep, keyed.end());
+        for (size_t i = 0; i < keep; ++i)
+            rows[i] = keyed[i].second;
+        return keep;
+    }
+
+    // What q orders row r by, ascending
+    static long long sortKey(const FlightQuery &q, const ScheduleSnapshot &s, const FlightColumns &c, int r, uint64_t now)
+    {
+        long long key = c.departure(r);
+        if (q.sortBy == SORT_ARRIVAL)
+            key = c.arrival(r);
+        else if (q.sortBy == SORT_DURATION)
+            key = (long long)c.arrival(r) - c.departure(r);
+        else if (q.sortBy == SORT_PRICE || q.sortBy == SORT_SEATS)
+        {
+            int seats, fare;
+            s.seatsAndFare(c.flightIndex(r), now, seats, fare);
+            key = q.sortBy == SORT_PRICE ? fare : seats;
+        }
+        return q.descending ? -key : key;
+    }
+
+    static void printMatch(ostream &os, const FlightView &f, const SeatState &seats)
+    {
+        os << "ID: " << f.flightID << " | " << f.source << "->" << f.destination
+           << " | Dep: " << minutesToTime(f.departureTime)
+           << " | Arr: " << minutesToTime(f.arrivalTime)
+           << " | Seats: " << seats.seatsAvailable << "/" << f.seatsTotal
+           << " | Price: " << seats.price << endl;
+    }
+
+    void printRoute(const RouteResult &r)
+    {
+        for (size_t i = 0; i < r.path.size(); ++i)
+        {
+            out << r.path[i];
+            if (i < r.path.size() - 1)
+                out << " -> ";
+        }
+        out << endl;
+        if (r.flights.empty())
+            return;
+        out << "Flights: ";
+        for (size_t i = 0; i < r.flights.size(); ++i)
+            out << r.flights[i] << (i + 1 < r.flights.size() ? ", " : "\n");
+    }
+
+    int binarySearchFlight(int flightID)
+    {
+        int left = 0, right = flights.size() - 1;
+        while (left <= right)
+        {
+            int mid = left + (right - left) / 2;
+            if (flights[mid].flightID == flightID)
+                return mid;
+            if (flights[mid].flightID < flightID)
+                left = mid + 1;
+            else
+                right = mid - 1;
+        }
+        return -1;
+    }
+
+    int assignSeat(Flight &flight)
+    {
+        for (int i = 0; i < flight.seatsTotal; ++i)
+        {
+            if (!flight.seatMap[i])
+            {
+                flight.seatMap[i] = true;
+                flight.seatsAvailable--;
+                return i + 1;
+            }
+        }
+        return -1;
+    }
+
+    int hireCrew(const string &name, CrewRole role)
+    {
+        int id = nextCrewID++;
+        crew[id] = CrewMember(id, name, role);
+        roster.add(id, role, 0);
+        publish(NULL, 0, true);
+        return id;
+    }
+
+    // Bit of a qualification such as "A320", "base:DEL" or "lang:Tamil";
+    // with `create`, unknown names get the next free bit. -1 when not found
+    // or when all 64 bits are taken.
+    int qualificationBit(const string &name, bool create)
+    {
+        for (size_t i = 0; i < qualificationNames.size(); ++i)
+            if (qualificationNames[i] == name)
+                return i;
+        if (!create || qualificationNames.size() == 64)
+            return -1;
+        qualificationNames.push_back(name);
+        return qualificationNames.size() - 1;
+    }
+
+    string describeQualifications(uint64_t mask) const
+    {
+        string text;
+        for (size_t i = 0; i < qualificationNames.size(); ++i)
+            if (mask >> i & 1)
+                text += (text.empty() ? "" : ", ") + qualificationNames[i];
+        return text.empty() ? "none" : text;
+    }
+
+    bool isCrewAvailable(int crewID, int dep, int arr)
+    {
+        TRACE_SPAN("isCrewAvailable", crewID);
+        // Get the set of flights already assigned to this crew member
+        set<int> &assigned = crew[crewID].assignedFlights;
+        // Check for time conflicts with each assigned flight
+        for (set<int>::iterator it = assigned.begin(); it != assigned.end(); ++it)
+        {
+            int fid = *it;
+            int idx = binarySearchFlight(fid);
+            if (idx == -1)
+                continue;
+            Flight &f = flights[idx];
+            // If times overlap, crew is not available for this flight
+            if (!(arr <= f.departureTime || dep >= f.arrivalTime))
+            {
+                return false;
+            }
+        }
+        // No conflicts found, crew is available
+        return true;
+    }
+
+    // Backtracking for crew assignment to a flight
+    bool assignCrewToFlight(int flightIdx, vector<int> &pilotIDs, vector<int> &attendantIDs)
+    {
+        Flight &f = flights[flightIdx];
+        TRACE_SPAN("assignCrewToFlight", f.flightID);
+
+        // Count already assigned pilots and attendants for this flight
+        int pilotCount = 0, attendantCount = 0;
+        for (int cid : f.crewAssigned)
+        {
+            uint32_t role = 1u << crew[cid].role;
+            pilotCount += (role & FLIGHT_DECK_ROLES) != 0;
+            attendantCount += (role & CABIN_ROLES) != 0;
+        }
+        // If already enough crew assigned, skip assignment
+        if (pilotCount >= 2 && attendantCount >= 2)
+        {
+            out << "Flight " << f.flightID << ": Already has 2 pilots and 2 attendants assigned. Skipping assignment.\n";
+            return false;
+        }
+
+        // Find available pilots and attendants
+        vector<int> assignedPilots, assignedAttendants;
+        for (size_t i = 0; i < pilotIDs.size() && assignedPilots.size() < 2 - pilotCount; ++i)
+        {
+            int pid = pilotIDs[i];
+            if (isCrewAvailable(pid, f.departureTime, f.arrivalTime))
+                assignedPilots.push_back(pid);
+        }
+        for (size_t i = 0; i < attendantIDs.size() && assignedAttendants.size() < 2 - attendantCount; ++i)
+        {
+            int aid = attendantIDs[i];
+            if (isCrewAvailable(aid, f.departureTime, f.arrivalTime))
+                assignedAttendants.push_back(aid);
+        }
+
+        int totalPilots = pilotCount + assignedPilots.size();
+        int totalAttendants = attendantCount + assignedAttendants.size();
+
+        if (totalPilots == 2 && totalAttendants == 2)
+        {
+            // Assign crew
+            for (int pid : assignedPilots)
+            {
+                f.crewAssigned.push_back(pid);
+                crew[pid].assignedFlights.insert(f.flightID);
+            }
+            for (int aid : assignedAttendants)
+            {
+                f.crewAssigned.push_back(aid);
+                crew[aid].assignedFlights.insert(f.flightID);
+            }
+            // cout << "Flight " << f.flightID << ": Crew assigned";
+            // cout << "  Pilots: ";
+            // for (int cid : f.crewAssigned) if (crew[cid].role == "Pilot") cout << cid << " ";
+            // cout << "\n  Attendants: ";
+            // for (int cid : f.crewAssigned) if (crew[cid].role == "Attendant") cout << cid << " ";
+            // cout << "\n";
+            return true;
+        }
+        else
+        {
+            int neededPilots = 2 - totalPilots;
+            int neededAttendants = 2 - totalAttendants;
+            out << "Flight " << f.flightID << ": Could not assign required crew. Needed "
+                << neededPilots << " more flight deck and " << neededAttendants << " more cabin crew.\n";
+            return false;
+        }
+    }
+
+public:
+    explicit AirlinesSystem(ostream &os = cout) : out(os)
+    {
+        // Add a default admin
+        admins["admin"] = Admin("admin", "admin123");
+        // Add some crew
+        hireCrew("John Pilot", ROLE_PILOT);
+        hireCrew("Jane CoPilot", ROLE_CO_PILOT);
+        hireCrew("Alice Attendant", ROLE_ATTENDANT);
+        hireCrew("Bob Attendant", ROLE_ATTENDANT);
+        hireCrew("Divyansh", ROLE_PILOT);
+        hireCrew("Somu", ROLE_PILOT);
+        hireCrew("Aditya", ROLE_ATTENDANT);
+        hireCrew("Arman", ROLE_ATTENDANT);
+        hireCrew("Tanya", ROLE_ATTENDANT);
+        // Coordinates of the airports we serve, used to bound route searches
+        airportGraph.setAirportLocation("DEL", 28.5562, 77.1000);
+        airportGraph.setAirportLocation("MUM", 19.0896, 72.8656);
+        airportGraph.setAirportLocation("BLR", 13.1986, 77.7066);
+        airportGraph.setAirportLocation("MAA", 12.9941, 80.1709);
+        airportGraph.setAirportLocation("CCU", 22.6547, 88.4467);
+        airportGraph.setAirportLocation("HYD", 17.2403, 78.4294);
+        airportGraph.setAirportLocation("GOI", 15.3808, 73.8314);
+        airportGraph.setAirportLocation("COK", 10.1520, 76.4019);
+    }
+
+    // Makes this instance issue flight IDs 1000 + k * shardCount + shard, so
+    // the owning shard of any flight ID is (ID - 1000) % shardCount. Must be
+    // called before the first flight is added.
+    void partitionFlightIDs(int shard, int shardCount)
+    {
+        nextFlightID = 1000 + shard;
+        flightIDStride = shardCount;
+    }
+
+    // Benchmarks turn this off so their synthetic calls stay out of the
+    // process-wide metrics report
+    void setMetricsRecording(bool on)
+    {
+        recordMetrics = on;
+    }
+
+    // Records every following call to `path` for --replay. Logins are not
+    // recorded (they change nothing) and neither are passwords.
+    bool startCallCapture(const string &path)
+    {
+        callLog.reset(new CallWriter());
+        if (!callLog->open(path))
+        {
+            callLog.reset();
+            return false;
+        }
+        return true;
+    }
+
+    // Replaces the wall clock behind hold expiry, so a replay expires holds
+    // at the same points of the trace however fast it runs
+    void pinClock(uint64_t millis)
+    {
+        pinnedClock = millis;
+    }
+
+    // --- User Authentication ---
+    bool registerPassenger(string username, string password, string name)
+    {
+        METRIC_SCOPE(OP_REGISTER);
+        logCall(CALL_REGISTER, username, name);
+        if (passengers.count(username) || admins.count(username))
+            return false;
+        passengers[username] = Passenger(username, password, name);
+        return true;
+    }
+
+    bool hasPassenger(string username)
+    {
+        return passengers.count(username) > 0;
+    }
+
+    Passenger *loginPassenger(string username, string password)
+    {
+        METRIC_SCOPE(OP_LOGIN);
+        if (passengers.count(username) && passengers[username].password == password)
+            return &passengers[username];
+        return NULL;
+    }
+
+    Admin *loginAdmin(string username, string password)
+    {
+        METRIC_SCOPE(OP_LOGIN);
+        if (admins.count(username) && admins[username].password == password)
+            return &admins[username];
+        return NULL;
+    }
+
+    // --- Flight Management (Admin) ---
+    int addFlight(string src, string dest, int dep, int arr, int seats, double price)
+    {
+        METRIC_SCOPE(OP_ADD_FLIGHT);
+        logCall(CALL_ADD_FLIGHT, src, dest, dep, arr, seats, price);
+        Flight f(nextFlightID, src, dest, dep, arr, seats, price);
+        nextFlightID += flightIDStride;
+        flights.push_back(f);
+        sort(flights.begin(), flights.end(), [](const Flight &a, const Flight &b)
+             { return a.flightID < b.flightID; });
+        airportGraph.addFlight(flights.back());
+        {
+            // IDs only grow, so the new flight is last and the rest keep their chunks
+            lock_guard<mutex> guard(publishLock);
+            versions.appendFlight(flights.back());
+            versions.publish();
+        }
+        if (routeIndexEnabled)
+            routeIndex.requestRebuild(airportGraph);
+        out << "Flight added: ID " << flights.back().flightID << endl;
+        return flights.back().flightID;
+    }
+
+    void removeFlight(int flightID)
+    {
+        METRIC_SCOPE(OP_REMOVE_FLIGHT);
+        logCall(CALL_REMOVE_FLIGHT, flightID);
+        int idx = binarySearchFlight(flightID);
+        if (idx == -1)
+        {
+            out << "Flight not found.\n";
+            return;
+        }
+        airportGraph.removeFlight(flights[idx]);
+        if (routeIndexEnabled)
+            routeIndex.requestRebuild(airportGraph);
+        flights.erase(flights.begin() + idx);
+        publishSchedule();
+        out << "Flight removed.\n";
+    }
+
+    void updateFlight(int flightID, int dep, int arr, int seats, double price)
+    {
+        METRIC_SCOPE(OP_UPDATE_FLIGHT);
+        logCall(CALL_UPDATE_FLIGHT, flightID, dep, arr, seats, price);
+        int idx = binarySearchFlight(flightID);
+        if (idx == -1)
+        {
+            out << "Flight not found.\n";
+            return;
+        }
+        flights[idx].departureTime = dep;
+        flights[idx].arrivalTime = arr;
+        flights[idx].seatsTotal = seats;
+        flights[idx].seatsAvailable = seats;
+        flights[idx].basePrice = price;
+        // Held seats go with the old seat map; their holds must not confirm or
+        // free seat numbers that now belong to new bookings
+        for (unordered_map<long long, SeatHold>::iterator it = holds.begin(); it != holds.end();)
+        {
+            if (it->second.flightID != flightID)
+            {
+                ++it;
+                continue;
+            }
+            holdTimers.cancel(it->second.timer);
+            it = holds.erase(it);
+        }
+        flights[idx].seatMap = vector<bool>(seats, false);
+        flights[idx].holdExpiries.clear();
+        publish(flights[idx]);
+        airportGraph.updateFlight(flights[idx]);
+        if (routeIndexEnabled)
+            routeIndex.requestRebuild(airportGraph);
+        out << "Flight updated.\n";
+    }
+
+    // Moves a flight's departure and arrival by the given minutes (negative
+    // for earlier) without touching its seats or bookings, then rechecks only
+    // what the new times can break: its graph edge, the other duties of its
+    // crew and its passengers' connections. Crew keep the shifted flight and
+    // are released from duties it now overlaps; those flights are re-crewed.
+    bool delayFlight(int flightID, int departureDelay, int arrivalDelay)
+    {
+        METRIC_SCOPE(OP_DELAY_FLIGHT);
+        logCall(CALL_DELAY_FLIGHT, flightID, departureDelay, arrivalDelay);
+        TRACE_SPAN("delayFlight", flightID);
+        int idx = binarySearchFlight(flightID);
+        if (idx == -1)
+        {
+            out << "Flight not found.\n";
+            return false;
+        }
+        Flight &f = flights[idx];
+        int oldDep = f.departureTime, oldArr = f.arrivalTime;
+        if (oldArr + arrivalDelay < oldDep + departureDelay)
+        {
+            out << "Error: The flight would arrive before it departs.\n";
+            return false;
+        }
+        f.departureTime += departureDelay;
+        f.arrivalTime += arrivalDelay;
+        out << "Flight " << flightID << " now departs " << minutesToTime(f.departureTime)
+            << " and arrives " << minutesToTime(f.arrivalTime) << ".\n";
+        // Edges carry durations only, so a plain shift leaves the graph as it is
+        if (departureDelay != arrivalDelay)
+        {
+            airportGraph.updateFlight(f);
+            if (routeIndexEnabled)
+                routeIndex.requestRebuild(airportGraph);
+        }
+
+        ArenaScope arena;
+        pmr::vector<int> recrew(arena.resource()); // indices of flights that lost crew
+        int dutiesChecked = 0;
+        for (size_t i = 0; i < f.crewAssigned.size(); ++i)
+        {
+            CrewMember &c = crew[f.crewAssigned[i]];
+            for (set<int>::iterator it = c.assignedFlights.begin(); it != c.assignedFlights.end();)
+            {
+                int otherIdx = *it == flightID ? -1 : binarySearchFlight(*it);
+                if (otherIdx == -1)
+                {
+                    ++it;
+                    continue;
+                }
+                dutiesChecked++;
+                Flight &g = flights[otherIdx];
+                if (f.arrivalTime <= g.departureTime || f.departureTime >= g.arrivalTime)
+                {
+                    ++it;
+                    continue;
+                }
+                g.crewAssigned.erase(find(g.crewAssigned.begin(), g.crewAssigned.end(), c.id));
+                it = c.assignedFlights.erase(it);
+                out << c.name << " (ID " << c.id << ") released from flight " << g.flightID << ", which now overlaps.\n";
+                if (find(recrew.begin(), recrew.end(), otherIdx) == recrew.end())
+                    recrew.push_back(otherIdx);
+            }
+        }
+        vector<int> pilotIDs, attendantIDs;
+        pmr::vector<Flight *> changed(1, &f, arena.resource());
+        for (size_t i = 0; i < recrew.size(); ++i)
+        {
+            roster.filter(FLIGHT_DECK_ROLES, flights[recrew[i]].crewRequirements, pilotIDs);
+            roster.filter(CABIN_ROLES, flights[recrew[i]].crewRequirements, attendantIDs);
+            if (assignCrewToFlight(recrew[i], pilotIDs, attendantIDs))
+                out << "Flight " << flights[recrew[i]].flightID << " re-crewed.\n";
+            changed.push_back(&flights[recrew[i]]);
+        }
+        publish(changed.data(), changed.size(), !recrew.empty());
+
+        // Onward flights from our destination and feeders into our origin,
+        // reported when the transfer shrank below the minimum
+        pmr::vector<const string *> travellers(arena.resource());
+        for (size_t i = 0; i < f.bookings.size(); ++i)
+            if (f.bookings[i].active)
+                travellers.push_back(&f.bookings[i].passengerUsername);
+        sort(travellers.begin(), travellers.end(), [](const string *a, const string *b)
+             { return *a < *b; });
+        travellers.erase(unique(travellers.begin(), travellers.end(), [](const string *a, const string *b)
+                                { return *a == *b; }),
+                         travellers.end());
+        int tightConnections = 0;
+        for (size_t t = 0; t < travellers.size(); ++t)
+        {
+            const vector<int> &booked = passengers[*travellers[t]].bookings;
+            for (size_t k = 0; k < booked.size(); ++k)
+            {
+                if (booked[k] == flightID || find(booked.begin(), booked.begin() + k, booked[k]) != booked.begin() + k)
+                    continue;
+                int otherIdx = binarySearchFlight(booked[k]);
+                if (otherIdx == -1)
+                    continue;
+                const Flight &g = flights[otherIdx];
+                int before, after;
+                if (g.source == f.destination && g.departureTime >= oldArr)
+                {
+                    before = g.departureTime - oldArr;
+                    after = g.departureTime - f.arrivalTime;
+                }
+                else if (g.destination == f.source && g.arrivalTime <= oldDep)
+                {
+                    before = oldDep - g.arrivalTime;
+                    after = f.departureTime - g.arrivalTime;
+                }
+                else
+                    continue;
+                if (after >= before || after >= MIN_CONNECTION_MINUTES)
+                    continue;
+                tightConnections++;
+                bool onward = g.source == f.destination;
+                out << *travellers[t] << ": connection " << (onward ? flightID : g.flightID) << " -> "
+                    << (onward ? g.flightID : flightID) << " at " << (onward ? f.destination : f.source)
+                    << (after < 0 ? " is missed" : " is down to " + to_string(after) + " min") << ".\n";
+            }
+        }
+        out << "Rechecked " << dutiesChecked << " crew dut" << (dutiesChecked == 1 ? "y" : "ies") << " and "
+            << travellers.size() << " passenger" << (travellers.size() == 1 ? "" : "s") << "; "
+            << tightConnections << " connection" << (tightConnections == 1 ? "" : "s") << " at risk.\n";
+        return true;
+    }
+
+    void listFlights()
+    {
+        METRIC_SCOPE(OP_LIST_FLIGHTS);
+        logCall(CALL_LIST_FLIGHTS);
+        TRACE_SPAN("listFlights");
+        ScheduleView view = readView();
+        uint64_t now = nowMillis();
+
+        out << "Available Flights:\n";
+        for (size_t i = 0; i < view->size(); ++i)
+        {
+            const FlightView &f = view->flight(i);
+            SeatState seats = f.seatsAt(now);
+            out << "ID: " << f.flightID << " | " << f.source << "->" << f.destination
+                << " | Dep: " << minutesToTime(f.departureTime)
+                << " | Arr: " << minutesToTime(f.arrivalTime)
+                << " | Seats: " << seats.seatsAvailable << "/" << f.seatsTotal
+                << " | Price: " << seats.price << endl;
+        }
+    }
+
+    void setAirportLocation(string code, double lat, double lon)
+    {
+        METRIC_SCOPE(OP_SET_LOCATION);
+        logCall(CALL_SET_LOCATION, code, lat, lon);
+        if (lat < -90 || lat > 90 || lon < -180 || lon > 180)
+        {
+            out << "Error: Invalid coordinates.\n";
+            return;
+        }
+        airportGraph.setAirportLocation(code, lat, lon);
+        out << "Location set for " << code << ".\n";
+    }
+
+    // --- Crew Management (Admin) ---
+    bool addCrew(string name, string role)
+    {
+        METRIC_SCOPE(OP_ADD_CREW);
+        logCall(CALL_ADD_CREW, name, role);
+        CrewRole parsed = parseCrewRole(role);
+        if (parsed == ROLE_UNKNOWN)
+        {
+            out << "Error: Unknown role " << role << ". Use Pilot, Co-Pilot or Attendant.\n";
+            return false;
+        }
+        int id = hireCrew(name, parsed);
+        out << "Crew added: ID " << id << ", " << name << ", " << crewRoleName(parsed) << endl;
+        return true;
+    }
+
+    // Grants a qualification: an aircraft type rating ("A320"), a base
+    // ("base:DEL"), a language ("lang:Tamil") or anything else, up to 64 names
+    bool qualifyCrew(int crewID, string qualification)
+    {
+        METRIC_SCOPE(OP_QUALIFY_CREW);
+        logCall(CALL_QUALIFY_CREW, crewID, qualification);
+        unordered_map<int, CrewMember>::iterator it = crew.find(crewID);
+        if (it == crew.end())
+        {
+            out << "Crew member not found.\n";
+            return false;
+        }
+        int bit = qualificationBit(qualification, true);
+        if (bit == -1)
+        {
+            out << "Error: All 64 qualification slots are in use.\n";
+            return false;
+        }
+        it->second.qualifications |= 1ULL << bit;
+        roster.setQualifications(crewID, it->second.qualifications);
+        out << it->second.name << " now holds " << describeQualifications(it->second.qualifications) << ".\n";
+        return true;
+    }
+
+    // Every crew member assigned to the flight from now on must hold all of
+    // these; an empty list clears the requirements
+    bool setCrewRequirements(int flightID, const vector<string> &qualifications)
+    {
+        METRIC_SCOPE(OP_CREW_REQUIREMENTS);
+        logCall(CALL_CREW_REQUIREMENTS, flightID, qualifications);
+        int idx = binarySearchFlight(flightID);
+        if (idx == -1)
+        {
+            out << "Flight not found.\n";
+            return false;
+        }
+        uint64_t mask = 0;
+        for (size_t i = 0; i < qualifications.size(); ++i)
+        {
+            int bit = qualificationBit(qualifications[i], true);
+            if (bit == -1)
+            {
+                out << "Error: All 64 qualification slots are in use.\n";
+                return false;
+            }
+            mask |= 1ULL << bit;
+        }
+        flights[idx].crewRequirements = mask;
+        out << "Flight " << flightID << " crew must hold: " << describeQualifications(mask) << ".\n";
+        return true;
+    }
+
+    void assignCrewToAllFlights()
+    {
+        METRIC_SCOPE(OP_ASSIGN_CREW);
+        logCall(CALL_ASSIGN_CREW);
+        TRACE_SPAN("assignCrewToAllFlights");
+        vector<int> pilotIDs, attendantIDs;
+        vector<Flight *> crewed;
+        for (size_t i = 0; i < flights.size(); ++i)
+        {
+            roster.filter(FLIGHT_DECK_ROLES, flights[i].crewRequirements, pilotIDs);
+            roster.filter(CABIN_ROLES, flights[i].crewRequirements, attendantIDs);
+            if (assignCrewToFlight(i, pilotIDs, attendantIDs))
+            {
+                out << "Crew assigned to flight " << flights[i].flightID << endl;
+                crewed.push_back(&flights[i]);
+            }
+            else
+                out << "Could not assign crew to flight " << flights[i].flightID << endl;
+        }
+        publish(crewed.data(), crewed.size(), !crewed.empty());
+    }
+
+    void listCrew()
+    {
+        METRIC_SCOPE(OP_LIST_CREW);
+        logCall(CALL_LIST_CREW);
+        TRACE_SPAN("listCrew");
+        for (unordered_map<int, CrewMember>::iterator it = crew.begin(); it != crew.end(); ++it)
+        {
+            int id = it->first;
+            CrewMember &c = it->second;
+            out << "ID: " << id << ", Name: " << c.name << ", Role: " << crewRoleName(c.role)
+                << ", Qualifications: " << describeQualifications(c.qualifications) << endl;
+        }
+    }
+    pair<int, int> minCrewRequired(const vector<Flight> &flights)
+    {
+        TRACE_SPAN("minCrewRequired");
+        // Sort a copy: reordering the schedule itself would break binarySearchFlight
+        vector<pair<int, int>> times; // departure, arrival
+        for (size_t i = 0; i < flights.size(); ++i)
+            times.push_back(make_pair(flights[i].departureTime, flights[i].arrivalTime));
+        sort(times.begin(), times.end());
+
+        priority_queue<int, vector<int>, greater<int>> pilotAvailable;
+        priority_queue<int, vector<int>, greater<int>> attendantAvailable;
+
+        int totalPilots = 0;
+        int totalAttendants = 0;
+
+        for (const pair<int, int> &f : times)
+        {
+            int pilotsAssigned = 0;
+            int attendantsAssigned = 0;
+
+            while (!pilotAvailable.empty() && pilotAvailable.top() <= f.first && pilotsAssigned < 2)
+            {
+                pilotAvailable.pop();
+                pilotsAssigned++;
+            }
+            totalPilots += (2 - pilotsAssigned);
+
+            while (!attendantAvailable.empty() && attendantAvailable.top() <= f.first && attendantsAssigned < 2)
+            {
+                attendantAvailable.pop();
+                attendantsAssigned++;
+            }
+            totalAttendants += (2 - attendantsAssigned);
+
+            for (int i = 0; i < 2; ++i)
+            {
+                pilotAvailable.push(f.second);
+                attendantAvailable.push(f.second);
+            }
+        }
+
+        return {totalPilots, totalAttendants};
+    }
+    void checkCrewVacancy()
+    {
+        METRIC_SCOPE(OP_CREW_VACANCY);
+        logCall(CALL_CREW_VACANCY);
+        TRACE_SPAN("checkCrewVacancy");
+        int currentPilotsAvailable = roster.count(FLIGHT_DECK_ROLES);
+        int currentAttendantsAvailable = roster.count(CABIN_ROLES);
+
+        pair<int, int> required = minCrewRequired(flights);
+
+        int extraPilots = max(0, required.first - currentPilotsAvailable);
+        int extraAttendants = max(0, required.second - currentAttendantsAvailable);
+
+        out << "Add " << extraPilots << " more pilots" << endl;
+        out << "Add " << extraAttendants << " more attendants" << endl;
+    }
+
+    void searchFlights(string src, string dest)
+    {
+        METRIC_SCOPE(OP_SEARCH_ROUTE);
+        logCall(CALL_SEARCH, src, dest);
+        if (src.empty() || dest.empty())
+        {
+            out << "Error: Source or destination cannot be empty.\n";
+            return;
+        }
+
+        ScheduleView view = readView();
+        if (view->size() == 0)
+        {
+            out << "Error: No flights available.\n";
+            return;
+        }
+
+        out << "Flights from " << src << " to " << dest << ":\n";
+
+        // Served from the route index, listed in flight ID order as before
+        FlightQuery q;
+        q.source = src;
+        q.destination = dest;
+        ArenaScope arena;
+        pmr::string plan(arena.resource());
+        pmr::vector<int> rows(arena.resource());
+        uint64_t now = nowMillis();
+        size_t found = selectRows(q, *view, now, rows, plan);
+        const FlightColumns &c = view->queryColumns();
+        for (size_t i = 0; i < found; ++i)
+            rows[i] = c.flightIndex(rows[i]);
+        sort(rows.begin(), rows.begin() + found); // views are in ID order
+        for (size_t i = 0; i < found; ++i)
+        {
+            const FlightView &f = view->flight(rows[i]);
+            SeatState seats = f.seatsAt(now);
+            out << "ID: " << f.flightID << " | Dep: " << minutesToTime(f.departureTime)
+                << " | Arr: " << minutesToTime(f.arrivalTime)
+                << " | Seats: " << seats.seatsAvailable << "/" << f.seatsTotal
+                << " | Price: " << seats.price << endl;
+        }
+
+        if (found == 0)
+        {
+            out << "Error: No flights found from " << src << " to " << dest << ".\n";
+        }
+    }
+
+    void searchFlightsByTime(int earliestDep, int latestDep)
+    {
+        METRIC_SCOPE(OP_SEARCH_TIME);
+        logCall(CALL_SEARCH_TIME, earliestDep, latestDep);
+        if (earliestDep > latestDep)
+        {
+            out << "Error: Earliest departure time cannot be later than latest departure time.\n";
+            return;
+        }
+
+        ScheduleView view = readView();
+        if (view->size() == 0)
+        {
+            out << "No flights available.\n";
+            return;
+        }
+
+        out << "Flights departing between " << minutesToTime(earliestDep) << " and " << minutesToTime(latestDep) << ":\n";
+
+        uint64_t now = nowMillis();
+        bool found = false;
+        for (size_t i = 0; i < view->size(); ++i)
+        {
+            const FlightView &f = view->flight(i);
+
+            if (f.departureTime < 0 || f.departureTime > 1440)
+            {
+                out << "Error: Invalid departure time for flight ID " << f.flightID << ". Skipping this flight.\n";
+                continue;
+            }
+
+            if (f.departureTime >= earliestDep && f.departureTime <= latestDep)
+            {
+                found = true;
+                SeatState seats = f.seatsAt(now);
+                out << "ID: " << f.flightID << " | " << f.source << "->" << f.destination
+                    << " | Dep: " << minutesToTime(f.departureTime)
+                    << " | Arr: " << minutesToTime(f.arrivalTime)
+                    << " | Seats: " << seats.seatsAvailable << "/" << f.seatsTotal
+                    << " | Price: " << seats.price << endl;
+            }
+        }
+
+        if (!found)
+        {
+            out << "No flights found within the specified time range.\n";
+        }
+    }
+
+    // IDs of flights matching every constraint in q, sorted and limited as it asks
+    vector<int> matchFlights(const FlightQuery &q)
+    {
+        ScheduleView view = readView();
+        ArenaScope arena;
+        pmr::string plan(arena.resource());
+        pmr::vector<int> rows(arena.resource());
+        size_t found = selectRows(q, *view, nowMillis(), rows, plan);
+        const FlightColumns &c = view->queryColumns();
+        vector<int> ids(found);
+        for (size_t i = 0; i < found; ++i)
+            ids[i] = view->flight(c.flightIndex(rows[i])).flightID;
+        return ids;
+    }
+
+    void queryFlights(const FlightQuery &q)
+    {
+        METRIC_SCOPE(OP_QUERY_FLIGHTS);
+        logCall(CALL_QUERY_FLIGHTS, q);
+        TRACE_SPAN("queryFlights");
+        if (q.departFrom > q.departTo || q.arriveFrom > q.arriveTo)
+        {
+            out << "Error: Window start cannot be later than its end.\n";
+            return;
+        }
+        ScheduleView view = readView();
+        ArenaScope arena;
+        pmr::string plan(arena.resource());
+        pmr::vector<int> rows(arena.resource());
+        uint64_t now = nowMillis();
+        size_t found = selectRows(q, *view, now, rows, plan);
+        const FlightColumns &c = view->queryColumns();
+        out << "Plan: " << plan << endl;
+        for (size_t i = 0; i < found; ++i)
+        {
+            const FlightView &f = view->flight(c.flightIndex(rows[i]));
+            printMatch(out, f, f.seatsAt(now));
+        }
+        if (found == 0)
+            out << "No flights match.\n";
+    }
+
+    // queryFlights for the shard router: appends the first q.limit matches
+    // with their sort keys instead of printing them
+    void collectFlights(const FlightQuery &q, vector<FlightMatch> &matches)
+    {
+        METRIC_SCOPE(OP_QUERY_FLIGHTS);
+        ScheduleView view = readView();
+        ArenaScope arena;
+        pmr::string plan(arena.resource());
+        pmr::vector<int> rows(arena.resource());
+        uint64_t now = nowMillis();
+        size_t found = selectRows(q, *view, now, rows, plan);
+        const FlightColumns &c = view->queryColumns();
+        for (size_t i = 0; i < found; ++i)
+        {
+            const FlightView &f = view->flight(c.flightIndex(rows[i]));
+            ostringstream line;
+            printMatch(line, f, f.seatsAt(now));
+            matches.push_back(FlightMatch{sortKey(q, *view, c, rows[i], now), f.departureTime, f.flightID, line.str()});
+        }
+    }
+
+    void bookFlight(string username, int flightID)
+    {
+        METRIC_SCOPE(OP_BOOK);
+        logCall(CALL_BOOK, username, flightID);
+        expireHolds();
+        int idx = binarySearchFlight(flightID);
+        if (idx == -1)
+        {
+            out << "Flight not found.\n";
+            return;
+        }
+        Flight &f = flights[idx];
+        if (f.seatsAvailable > 0)
+        {
+            int seatNo = assignSeat(f);
+            f.bookings.push_back(Booking(username, seatNo));
+            passengers[username].bookings.push_back(flightID);
+            out << "Seat booked! Flight " << flightID << ", Seat #" << seatNo
+                << ", Price: " << dynamicPrice(f) << endl;
+        }
+        else
+        {
+            out << "No seats available. Added to waitlist.\n";
+            f.waitlist.push(WaitlistEntry(username));
+            f.waitlistedPassengers++;
+        }
+        publish(f);
+    }
+
+    void cancelBooking(string username, int flightID)
+    {
+        METRIC_SCOPE(OP_CANCEL);
+        logCall(CALL_CANCEL, username, flightID);
+        expireHolds();
+        int idx = binarySearchFlight(flightID);
+        if (idx == -1)
+        {
+            out << "Flight not found.\n";
+            return;
+        }
+        Flight &f = flights[idx];
+        int seatNo = -1;
+        for (size_t i = 0; i < f.bookings.size(); ++i)
+        {
+            Booking &b = f.bookings[i];
+            if (b.passengerUsername == username && b.active)
+            {
+                b.active = false;
+                seatNo = b.seatNo;
+                break;
+            }
+        }
+        if (seatNo != -1)
+        {
+            out << "Booking cancelled.\n";
+            // Assign seat to waitlist if any
+            freeSeat(f, seatNo);
+        }
+        else
+        {
+            out << "No active booking found for this user on this flight.\n";
+        }
+    }
+
+    // Books partySize seats for one account all-or-nothing, adjacent where
+    // possible; if the flight cannot take the whole party it is waitlisted as one
+    bool bookGroup(string username, int flightID, int partySize)
+    {
+        METRIC_SCOPE(OP_BOOK_GROUP);
+        logCall(CALL_BOOK_GROUP, username, flightID, partySize);
+        expireHolds();
+        int idx = binarySearchFlight(flightID);
+        if (idx == -1)
+        {
+            out << "Flight not found.\n";
+            return false;
+        }
+        Flight &f = flights[idx];
+        if (partySize < 1 || partySize > f.seatsTotal)
+        {
+            out << "Error: Party size must be between 1 and " << f.seatsTotal << ".\n";
+            return false;
+        }
+        if (f.seatsAvailable < partySize)
+        {
+            f.waitlist.push(WaitlistEntry(username, partySize));
+            f.waitlistedPassengers += partySize;
+            publish(f);
+            out << "Not enough seats for the whole party. Party of " << partySize << " added to waitlist.\n";
+            return false;
+        }
+        vector<int> seats;
+        bool adjacent = allocateSeats(f, partySize, seats);
+        vector<int> &mine = passengers[username].bookings;
+        for (size_t i = 0; i < seats.size(); ++i)
+        {
+            f.bookings.push_back(Booking(username, seats[i]));
+            mine.push_back(flightID);
+        }
+        publish(f);
+        out << "Group booked! Flight " << flightID << ", " << partySize << " seats ";
+        if (adjacent)
+            out << "#" << seats[0] << "-" << seats.back() << " (together)";
+        else
+            for (size_t i = 0; i < seats.size(); ++i)
+                out << (i ? ", #" : "#") << seats[i];
+        out << ", Price per seat: " << dynamicPrice(f) << endl;
+        return true;
+    }
+
+    // --- Seat Holds ---
+    // Takes a seat out of the allocator for holdTtlSeconds; returns the hold ID, or -1
+    long long holdSeat(string username, int flightID)
+    {
+        METRIC_SCOPE(OP_HOLD);
+        logCall(CALL_HOLD, username, flightID);
+        expireHolds();
+        int idx = binarySearchFlight(flightID);
+        if (idx == -1)
+        {
+            out << "Flight not found.\n";
+            return -1;
+        }
+        Flight &f = flights[idx];
+        if (f.seatsAvailable <= 0)
+        {
+            out << "No seats available to hold.\n";
+            return -1;
+        }
+        SeatHold h;
+        h.username = username;
+        h.flightID = flightID;
+        h.seatNo = assignSeat(f);
+        long long id = nextHoldID++;
+        h.expiresAt = nowMillis() + (uint64_t)holdTtlSeconds * 1000;
+        h.timer = holdTimers.schedule(id, h.expiresAt);
+        holds[id] = h;
+        f.holdExpiries.insert(upper_bound(f.holdExpiries.begin(), f.holdExpiries.end(), h.expiresAt), h.expiresAt);
+        publish(f);
+        out << "Seat #" << h.seatNo << " on flight " << flightID << " held for " << holdTtlSeconds
+            << " seconds. Hold ID: " << id << ", Price: " << dynamicPrice(f) << endl;
+        return id;
+    }
+
+    bool confirmHold(string username, long long holdID)
+    {
+        METRIC_SCOPE(OP_CONFIRM_HOLD);
+        logCall(CALL_CONFIRM_HOLD, username, holdID);
+        expireHolds();
+        unordered_map<long long, SeatHold>::iterator it = holds.find(holdID);
+        if (it == holds.end() || it->second.username != username)
+        {
+            out << "Hold not found or already expired.\n";
+            return false;
+        }
+        SeatHold h = it->second;
+        holdTimers.cancel(h.timer);
+        holds.erase(it);
+        int idx = binarySearchFlight(h.flightID);
+        if (idx != -1)
+            dropHoldExpiry(flights[idx], h.expiresAt);
+        if (idx == -1 || h.seatNo > flights[idx].seatsTotal || !flights[idx].seatMap[h.seatNo - 1])
+        {
+            if (idx != -1)
+                publish(flights[idx]);
+            out << "Flight changed since the hold was placed. Please book again.\n";
+            return false;
+        }
+        flights[idx].bookings.push_back(Booking(username, h.seatNo));
+        passengers[username].bookings.push_back(h.flightID);
+        publish(flights[idx]);
+        out << "Seat booked! Flight " << h.flightID << ", Seat #" << h.seatNo << endl;
+        return true;
+    }
+
+    bool releaseHold(string username, long long holdID)
+    {
+        METRIC_SCOPE(OP_RELEASE_HOLD);
+        logCall(CALL_RELEASE_HOLD, username, holdID);
+        expireHolds();
+        unordered_map<long long, SeatHold>::iterator it = holds.find(holdID);
+        if (it == holds.end() || it->second.username != username)
+        {
+            out << "Hold not found or already expired.\n";
+            return false;
+        }
+        SeatHold h = it->second;
+        holdTimers.cancel(h.timer);
+        holds.erase(it);
+        out << "Hold released.\n";
+        int idx = binarySearchFlight(h.flightID);
+        if (idx != -1)
+        {
+            dropHoldExpiry(flights[idx], h.expiresAt);
+            freeSeat(flights[idx], h.seatNo);
+        }
+        return true;
+    }
+
+    void setHoldTtl(int seconds)
+    {
+        logCall(CALL_SET_HOLD_TTL, seconds);
+        if (seconds <= 0)
+        {
+            out << "Error: TTL must be positive.\n";
+            return;
+        }
+        holdTtlSeconds = seconds;
+        out << "New holds expire after " << seconds << " seconds (" << holds.size() << " holds outstanding).\n";
+    }
+
+    void listPassengerBookings(string username)
+    {
+        METRIC_SCOPE(OP_LIST_BOOKINGS);
+        logCall(CALL_LIST_BOOKINGS, username);
+        expireHolds();
+        if (!passengers.count(username))
+        {
+            out << "Passenger not found.\n";
+            return;
+        }
+
+        out << "Bookings for " << username << ":\n";
+
+        bool foundBooking = false;
+
+        for (Flight &f : flights)
+        {
+            for (Booking &b : f.bookings)
+            {
+                if (b.passengerUsername == username && b.active)
+                {
+                    foundBooking = true;
+                    out << "Flight " << f.flightID << " | " << f.source << "->" << f.destination
+                        << " | Dep: " << minutesToTime(f.departureTime)
+                        << " | Seat #" << b.seatNo << endl;
+                }
+            }
+        }
+
+        if (!foundBooking)
+        {
+            out << "No bookings available.\n";
+        }
+    }
+
+    // --- Route Optimization ---
+    void findShortestRoute(string src, string dest, RouteSearchMode mode = SEARCH_ASTAR)
+    {
+        METRIC_SCOPE(OP_SHORTEST_ROUTE);
+        logCall(CALL_SHORTEST_ROUTE, src, dest, (int)mode);
+        TRACE_SPAN("findShortestRoute");
+        RouteResult &r = plannedRoute;
+        planRoute(src, dest, false, mode, r);
+        if (r.cost == -1)
+            out << "No route found.\n";
+        else
+        {
+            out << "Shortest route (" << r.cost << " mins): ";
+            printRoute(r);
+        }
+    }
+    void findCheapestRoute(string src, string dest, RouteSearchMode mode = SEARCH_BIDIRECTIONAL)
+    {
+        METRIC_SCOPE(OP_CHEAPEST_ROUTE);
+        logCall(CALL_CHEAPEST_ROUTE, src, dest, (int)mode);
+        TRACE_SPAN("findCheapestRoute");
+        RouteResult &r = plannedRoute;
+        planRoute(src, dest, true, mode, r);
+        if (r.cost == -1)
+            out << "No route found.\n";
+        else
+        {
+            out << "Cheapest route (" << r.cost << " INR): ";
+            printRoute(r);
+        }
+    }
+
+    // Takes one seat on every leg or on none. Each leg must leave from the
+    // previous leg's destination at least MIN_CONNECTION_MINUTES after it
+    // lands; otherwise nothing is locked and `missedFlight` names the leg.
+    // Legs are locked in ascending flight ID order, so concurrent itineraries
+    // that share flights cannot deadlock, and bookings on unrelated flights
+    // never wait for each other. Safe to call from several threads at once as
+    // long as nothing else changes the schedule meanwhile (holds included:
+    // nothing here expires them); prints nothing. On success `seats` holds the
+    // seat number of each leg.
+    bool reserveItinerary(const string &username, const vector<int> &legs, vector<int> &seats, int *fullFlight = NULL,
+                          int *missedFlight = NULL)
+    {
+        METRIC_SCOPE(OP_BOOK_ITINERARY);
+        seats.clear();
+        if (legs.empty())
+            return false;
+        vector<Flight *> legFlights;
+        for (size_t i = 0; i < legs.size(); ++i)
+        {
+            int idx = binarySearchFlight(legs[i]);
+            if (idx == -1)
+                return false;
+            legFlights.push_back(&flights[idx]);
+        }
+        for (size_t i = 1; i < legFlights.size(); ++i)
+            if (legFlights[i]->source != legFlights[i - 1]->destination ||
+                legFlights[i]->departureTime < legFlights[i - 1]->arrivalTime + MIN_CONNECTION_MINUTES)
+            {
+                if (missedFlight)
+                    *missedFlight = legFlights[i]->flightID;
+                return false;
+            }
+        // flights is sorted by ID, so address order is ID order
+        vector<Flight *> order(legFlights);
+        sort(order.begin(), order.end());
+        if (adjacent_find(order.begin(), order.end()) != order.end())
+            return false; // the same flight twice is not an itinerary
+
+        vector<unique_lock<mutex>> held;
+        {
+            TRACE_SPAN("lockLegs", (int)legs.size());
+            for (size_t i = 0; i < order.size(); ++i)
+                held.push_back(unique_lock<mutex>(*order[i]->seatLock));
+        }
+        for (size_t i = 0; i < legFlights.size(); ++i)
+            if (legFlights[i]->seatsAvailable == 0)
+            {
+                if (fullFlight)
+                    *fullFlight = legFlights[i]->flightID;
+                return false;
+            }
+        for (size_t i = 0; i < legFlights.size(); ++i)
+        {
+            int seatNo = assignSeat(*legFlights[i]);
+            legFlights[i]->bookings.push_back(Booking(username, seatNo));
+            seats.push_back(seatNo);
+        }
+        publish(legFlights.data(), legFlights.size());
+        held.clear();
+
+        lock_guard<mutex> guard(passengerLock);
+        vector<int> &booked = passengers[username].bookings;
+        booked.insert(booked.end(), legs.begin(), legs.end());
+        return true;
+    }
+
+    // Books the given legs as one itinerary, all or nothing
+    bool bookItinerary(string username, const vector<int> &legs)
+    {
+        logCall(CALL_BOOK_ITINERARY, username, legs);
+        return bookLegs(username, legs);
+    }
+
+    // Plans the fastest (or cheapest) route and books all of its flights
+    bool bookRoute(string username, string src, string dest, bool byPrice)
+    {
+        logCall(CALL_BOOK_ROUTE, username, src, dest, byPrice);
+        RouteResult &r = plannedRoute;
+        planRoute(src, dest, byPrice, byPrice ? SEARCH_BIDIRECTIONAL : SEARCH_ASTAR, r);
+        if (r.cost == -1 || r.flights.empty())
+        {
+            out << "No route found.\n";
+            return false;
+        }
+        return bookLegs(username, r.flights);
+    }
+
+    // Consistent, unchanging copy of the flights and crew as of the last
+    // completed change. Safe from any thread, including while itineraries
+    // are booked; it never blocks a writer.
+    ScheduleView readView() const
+    {
+        return ScheduleView(versions);
+    }
+
+    // Seats taken across every flight; lets benchmarks audit concurrent bookings
+    long long seatsSold() const
+    {
+        long long sold = 0;
+        for (size_t i = 0; i < flights.size(); ++i)
+            sold += flights[i].seatsTotal - flights[i].seatsAvailable;
+        return sold;
+    }
+
+    void reachableFrom(string src, int limit, bool byPrice)
+    {
+        METRIC_SCOPE(OP_REACHABLE);
+        logCall(CALL_REACHABLE, src, limit, byPrice);
+        airportGraph.reachableWithin(src, limit, byPrice, reachable);
+        if (reachable.size() <= 1)
+        {
+            out << "No airports reachable from " << src << " within " << limit << (byPrice ? " INR" : " mins") << ".\n";
+            return;
+        }
+        out << "Reachable from " << src << " within " << limit << (byPrice ? " INR" : " mins") << ":\n";
+        ArenaScope arena;
+        pmr::vector<int> chain(arena.resource());
+        for (size_t i = 1; i < reachable.size(); ++i)
+        {
+            chain.clear();
+            for (int cur = i; cur != -1; cur = reachable[cur].parent)
+                chain.push_back(cur);
+            out << reachable[i].code << " (" << reachable[i].cost << (byPrice ? " INR" : " mins") << "): ";
+            for (size_t j = chain.size(); j-- > 0;)
+            {
+                out << reachable[chain[j]].code;
+                if (j > 0)
+                    out << " -> ";
+            }
+            out << endl;
+        }
+    }
+
+    // Answers many route queries at once; results line up with `queries`
+    vector<RouteResult> batchRoutes(const vector<RouteQuery> &queries)
+    {
+        METRIC_SCOPE(OP_BATCH_ROUTES);
+        logCall(CALL_BATCH_ROUTES, queries);
+        if (!queryPool)
+            queryPool.reset(new WorkStealingPool(thread::hardware_concurrency()));
+        return ::batchRoutes(airportGraph, queries, *queryPool);
+    }
+
+    void setTraceRecording(bool on, string path)
+    {
+#if FLIGHTEASE_TRACING
+        if (on)
+        {
+            TraceRecorder::instance().start();
+            out << "Trace recording started.\n";
+            return;
+        }
+        TraceRecorder::instance().stop();
+        ofstream file(path.c_str());
+        if (!file)
+        {
+            out << "Error: Cannot write " << path << ".\n";
+            return;
+        }
+        size_t spans = TraceRecorder::instance().exportJson(file);
+        out << "Wrote " << spans << " spans to " << path << " (open in chrome://tracing or ui.perfetto.dev).\n";
+#else
+        out << "Tracing was compiled out (FLIGHTEASE_TRACING=0).\n";
+#endif
+    }
+
+    void metricsReport()
+    {
+#if FLIGHTEASE_METRICS
+        out << "Performance Metrics:\n";
+        MetricsRegistry::instance().report(out);
+#else
+        out << "Metrics were compiled out (FLIGHTEASE_METRICS=0).\n";
+#endif
+    }
+
+    void setRouteIndexEnabled(bool enabled)
+    {
+        logCall(CALL_ROUTE_INDEX, enabled);
+        routeIndexEnabled = enabled;
+        if (enabled)
+        {
+            routeIndex.requestRebuild(airportGraph);
+            out << "Route index enabled; building in the background.\n";
+        }
+        else
+        {
+            routeIndex.clear();
+            out << "Route index disabled.\n";
+        }
+    }
+
+    void setDistanceTableEnabled(bool enabled)
+    {
+        logCall(CALL_DISTANCE_TABLE, enabled);
+        distanceTableEnabled = enabled;
+        if (!enabled)
+        {
+            distanceTables.clear();
+            distanceTableRequested = make_pair(-1LL, (size_t)0);
+            out << "All-pairs table disabled.\n";
+        }
+        else if (airportGraph.airportCodes.size() > (size_t)DistanceTable::MAX_AIRPORTS)
+            out << "Network exceeds " << DistanceTable::MAX_AIRPORTS << " airports; routes will be searched directly.\n";
+        else
+        {
+            currentDistanceTable(); // queues the first build
+            out << "All-pairs table enabled; building in the background.\n";
+        }
+    }
+
+    void routeIndexReport()
+    {
+        out << "Route Index Report:\n";
+        if (distanceTableEnabled)
+        {
+            shared_ptr<const DistanceTable> table = distanceTables.current();
+            if (table)
+                out << "All-pairs table: " << table->n << " airports, last built in "
+                    << table->buildMillis << " ms" << (table->current(airportGraph) ? "" : " (stale)") << endl;
+            out << "All-pairs status: " << (distanceTables.building() ? "rebuilding" : "idle")
+                << " | Queries answered by direct search while rebuilding: " << tableFallbackQueries << endl;
+        }
+        if (!routeIndexEnabled)
+        {
+            out << "Route index is disabled.\n";
+            return;
+        }
+        shared_ptr<const ContractionHierarchy> index = routeIndex.current();
+        if (index)
+        {
+            out << "Airports: " << index->airportCodes.size() << " | Shortcuts: " << index->shortcuts
+                << " | Preprocessing: " << index->buildMillis << " ms"
+                << (index->version == airportGraph.version ? "" : " (stale)") << endl;
+        }
+        out << "Status: " << (routeIndex.building() ? "rebuilding" : "idle") << endl;
+        out << "Queries served from index: " << indexedQueries;
+        if (indexedQueries)
+            out << " (avg " << indexedQueryMicros / indexedQueries << " us)";
+        out << "\nQueries answered by direct search while rebuilding: " << fallbackQueries << endl;
+    }
+
+    // --- Reporting ---
+    void flightOccupancyReport()
+    {
+        METRIC_SCOPE(OP_OCCUPANCY_REPORT);
+        logCall(CALL_OCCUPANCY_REPORT);
+        TRACE_SPAN("flightOccupancyReport");
+        ScheduleView view = readView();
+        uint64_t now = nowMillis();
+        out << "Flight Occupancy Report:\n";
+        for (size_t i = 0; i < view->size(); ++i)
+        {
+            const FlightView &f = view->flight(i);
+            double occ = 100.0 * (f.seatsTotal - f.seatsAt(now).seatsAvailable) / f.seatsTotal;
+            out << "Flight " << f.flightID << ": " << occ << "% full\n";
+        }
+    }
+
+    void waitlistReport()
+    {
+        METRIC_SCOPE(OP_WAITLIST_REPORT);
+        logCall(CALL_WAITLIST_REPORT);
+        TRACE_SPAN("waitlistReport");
+        ScheduleView view = readView();
+        uint64_t now = nowMillis();
+        out << "Waitlist Report:\n";
+        for (size_t i = 0; i < view->size(); ++i)
+        {
+            const FlightView &f = view->flight(i);
+            out << "Flight " << f.flightID << ": " << f.seatsAt(now).waitlistedPassengers << " on waitlist\n";
+        }
+    }
+    void printAllDuties();
+};
+void AirlinesSystem::printAllDuties()
+{
+    METRIC_SCOPE(OP_PRINT_DUTIES);
+    logCall(CALL_PRINT_DUTIES);
+    TRACE_SPAN("printAllDuties");
+    ScheduleView view = readView();
+    out << "\n----- Crew Duties -----\n";
+    for (const CrewView &c : view->crew())
+    {
+        out << "Crew ID: " << c.id << " | Role: " << crewRoleName(c.role) << "\n";
+        if (c.flights.empty())
+        {
+            out << "  No flights assigned.\n";
+        }
+        else
+        {
+            for (int fid : c.flights)
+            {
+                const FlightView *it = view->find(fid);
+                if (it)
+                {
+                    out << "  Flight ID: " << it->flightID
+                        << " | Departure: " << it->departureTime
+                        << " | Arrival: " << it->arrivalTime << "\n";
+                }
+                else
+                {
+                    out << "  Flight ID: " << fid << " (details not found)\n";
+                }
+            }
+        }
+        out << "-------------------------\n";
+    }
+}
+
+// ---------------------- Sharded Deployment ----------------------
+// Splits the schedule across independent AirlinesSystem shards by origin
+// airport: a flight, its seats, bookings, waitlist and holds all live on the
+// shard of the airport it departs from. Shards interleave their flight IDs,
+// so bookings and cancellations go straight to the owner. Each shard has its
+// own lock, so requests for different shards run in parallel; reports fan
+// out to every shard in turn. Crew and route planning stay per shard.
+// Accounts are registered on every shard, so each shard keeps the bookings
+// made on it. The router has no menu or server front end; it is driven by
+// the sharded throughput benchmark.
+class ShardRouter
+{
+public:
+    // With a sink, each shard prints to its own stream over it instead of cout
+    explicit ShardRouter(int shardCount, streambuf *sink = NULL)
+    {
+        shardCount = max(1, shardCount);
+        for (int i = 0; i < shardCount; ++i)
+        {
+            unique_ptr<Shard> s(new Shard());
+            if (sink)
+                s->stream.reset(new ostream(sink));
+            s->out = sink ? s->stream.get() : &cout;
+            s->sys.reset(new AirlinesSystem(*s->out));
+            s->sys->partitionFlightIDs(i, shardCount);
+            shards.push_back(move(s));
+        }
+    }
+
+    int size() const { return shards.size(); }
+
+    void setMetricsRecording(bool on)
+    {
+        for (size_t i = 0; i < shards.size(); ++i)
+            shards[i]->sys->setMetricsRecording(on);
+    }
+
+    int shardOf(const string &airport) const
+    {
+        return hash<string>()(airport) % shards.size();
+    }
+
+    // IDs below the first one issued go to shard 0, which reports them as unknown
+    int shardOfFlight(int flightID) const
+    {
+        return flightID < 1000 ? 0 : (flightID - 1000) % shards.size();
+    }
+
+    // The router's list answers hasPassenger without touching a shard
+    bool registerPassenger(const string &username, const string &password, const string &name)
+    {
+        {
+            lock_guard<mutex> guard(accountLock);
+            if (!accounts.insert(make_pair(username, Passenger(username, password, name))).second)
+                return false;
+        }
+        for (size_t i = 0; i < shards.size(); ++i)
+        {
+            lock_guard<mutex> guard(shards[i]->lock);
+            shards[i]->sys->registerPassenger(username, password, name);
+        }
+        return true;
+    }
+
+    bool hasPassenger(const string &username)
+    {
+        lock_guard<mutex> guard(accountLock);
+        return accounts.count(username) > 0;
+    }
+
+    int addFlight(const string &src, const string &dest, int dep, int arr, int seats, double price)
+    {
+        Shard &s = *shards[shardOf(src)];
+        lock_guard<mutex> guard(s.lock);
+        return s.sys->addFlight(src, dest, dep, arr, seats, price);
+    }
+
+    void bookFlight(const string &username, int flightID)
+    {
+        Shard &s = *shards[shardOfFlight(flightID)];
+        bool known = hasPassenger(username);
+        lock_guard<mutex> guard(s.lock);
+        if (known)
+            s.sys->bookFlight(username, flightID);
+        else
+            *s.out << "Passenger not found.\n";
+    }
+
+    void cancelBooking(const string &username, int flightID)
+    {
+        Shard &s = *shards[shardOfFlight(flightID)];
+        bool known = hasPassenger(username);
+        lock_guard<mutex> guard(s.lock);
+        if (known)
+            s.sys->cancelBooking(username, flightID);
+        else
+            *s.out << "Passenger not found.\n";
+    }
+
+    // Every flight out of src is on src's shard
+    void searchFlights(const string &src, const string &dest)
+    {
+        Shard &s = *shards[shardOf(src)];
+        lock_guard<mutex> guard(s.lock);
+        s.sys->searchFlights(src, dest);
+    }
+
+    // A query from one airport touches only its shard. Any other query
+    // collects each shard's first q.limit matches, merges them by q's order
+    // and applies the limit once, so the result is what one system would give
+    void queryFlights(const FlightQuery &q)
+    {
+        if (!q.source.empty())
+        {
+            Shard &s = *shards[shardOf(q.source)];
+            lock_guard<mutex> guard(s.lock);
+            s.sys->queryFlights(q);
+            return;
+        }
+        vector<FlightMatch> matches;
+        if (q.departFrom <= q.departTo && q.arriveFrom <= q.arriveTo)
+        {
+            for (size_t i = 0; i < shards.size(); ++i)
+            {
+                Shard &s = *shards[i];
+                lock_guard<mutex> guard(s.lock);
+                s.sys->collectFlights(q, matches);
+            }
+        }
+        size_t keep = q.limit > 0 ? min<size_t>(q.limit, matches.size()) : matches.size();
+        partial_sort(matches.begin(), matches.begin() + keep, matches.end());
+
+        Shard &s = *shards[0];
+        lock_guard<mutex> guard(s.lock);
+        if (q.departFrom > q.departTo || q.arriveFrom > q.arriveTo)
+        {
+            *s.out << "Error: Window start cannot be later than its end.\n";
+            return;
+        }
+        *s.out << "Plan: merged from " << shards.size() << " shards (" << matches.size()
+               << (matches.size() == 1 ? " match)\n" : " matches)\n");
+        for (size_t i = 0; i < keep; ++i)
+            *s.out << matches[i].line;
+        if (keep == 0)
+            *s.out << "No flights match.\n";
+    }
+
+    void searchFlightsByTime(int earliestDep, int latestDep)
+    {
+        forEachShard([&](AirlinesSystem &sys)
+                     { sys.searchFlightsByTime(earliestDep, latestDep); });
+    }
+
+    void listFlights()
+    {
+        forEachShard([](AirlinesSystem &sys)
+                     { sys.listFlights(); });
+    }
+
+    void listPassengerBookings(const string &username)
+    {
+        if (!hasPassenger(username))
+        {
+            Shard &s = *shards[0];
+            lock_guard<mutex> guard(s.lock);
+            *s.out << "Passenger not found.\n";
+            return;
+        }
+        forEachShard([&](AirlinesSystem &sys)
+                     { sys.listPassengerBookings(username); });
+    }
+
+    void flightOccupancyReport()
+    {
+        forEachShard([](AirlinesSystem &sys)
+                     { sys.flightOccupancyReport(); });
+    }
+
+    void waitlistReport()
+    {
+        forEachShard([](AirlinesSystem &sys)
+                     { sys.waitlistReport(); });
+    }
+
+private:
+    struct Shard
+    {
+        mutex lock;
+        unique_ptr<ostream> stream;
+        ostream *out;
+        unique_ptr<AirlinesSystem> sys;
+    };
+    vector<unique_ptr<Shard>> shards;
+    mutex accountLock;
+    unordered_map<string, Passenger> accounts;
+
+    template <typename Op>
+    void forEachShard(Op op)
+    {
+        for (size_t i = 0; i < shards.size(); ++i)
+        {
+            Shard &s = *shards[i];
+            lock_guard<mutex> guard(s.lock);
+            *s.out << "[Shard " << i << "]\n";
+            op(*s.sys);
+        }
+    }
+};
+
+// Times N single bookFlight calls against one bookGroup of N on a fresh
+// flight, for family-sized parties up to charter blocks. Both ways must
+// sell the same seats.
+long long runGroupBookingBenchmark(ostream &os, int seats, int repeats)
+{
+    Benchmark bench(os);
+    int sizes[] = {5, 20, 50, 200};
+    os << left << setw(12) << "Party" << setw(22) << "N x bookFlight(us)" << setw(20) << "bookGroup(us)"
+       << setw(10) << "Speedup" << "Audit\n";
+    for (int p = 0; p < 4; ++p)
+    {
+        int party = sizes[p];
+        if (party > seats)
+            break;
+        double single = 0, group = 0;
+        bool consistent = true;
+        for (int r = 0; r < repeats; ++r)
+        {
+            AirlinesSystem a(bench.quiet), b(bench.quiet);
+            a.setMetricsRecording(false);
+            b.setMetricsRecording(false);
+            a.addFlight("DEL", "BOM", 480, 600, seats, 5000);
+            b.addFlight("DEL", "BOM", 480, 600, seats, 5000);
+            a.registerPassenger("family", "pw", "Family");
+            b.registerPassenger("family", "pw", "Family");
+            // Half-full cabin so searches have to skip occupied seats
+            for (int i = 0; i < (seats - party) / 2; ++i)
+            {
+                a.bookFlight("filler", 1000);
+                b.bookFlight("filler", 1000);
+            }
+            bench.startTimer();
+            for (int i = 0; i < party; ++i)
+                a.bookFlight("family", 1000);
+            single += bench.elapsed() * 1e6;
+            bench.startTimer();
+            b.bookGroup("family", 1000, party);
+            group += bench.elapsed() * 1e6;
+            consistent = consistent && a.seatsSold() == b.seatsSold();
+        }
+        ostringstream speedup;
+        speedup << fixed << setprecision(1) << single / max(group, 1e-3) << "x";
+        os << left << setw(12) << party << setw(22) << fixed << setprecision(1) << single / repeats
+           << setw(20) << group / repeats << setw(10) << speedup.str() << bench.audit(consistent) << "\n";
+    }
+    return bench.failures();
+}
+
+// Itinerary fixtures. Flights come in threes, <prefix>i -> <prefix>i+1, with
+// an hour to connect inside each three; a plan is the first two or all three
+// legs of one of them. IDs assume a fresh system, which numbers from 1000.
+void addConnectingFlights(AirlinesSystem &sys, const string &prefix, int flightCount, int seats)
+{
+    for (int i = 0; i < flightCount; ++i)
+    {
+        int dep = 360 + i % 3 * 180;
+        sys.addFlight(prefix + to_string(i), prefix + to_string(i + 1), dep, dep + 120, seats, 4000);
+    }
+}
+
+vector<vector<int>> connectingPlans(mt19937 &rng, int flightCount, int itineraries)
+{
+    uniform_int_distribution<int> pickTrip(0, flightCount / 3 - 1), legCount(2, 3);
+    vector<vector<int>> plans(itineraries);
+    for (int i = 0; i < itineraries; ++i)
+    {
+        int first = 1000 + 3 * pickTrip(rng);
+        for (int n = legCount(rng), k = 0; k < n; ++k)
+            plans[i].push_back(first + k);
+    }
+    return plans;
+}
+
+// Books random two- and three-leg itineraries from several threads at once,
+// with per-flight locks and then with one global lock around every booking.
+// Flights get three quarters of the average demand, so around a third of
+// the itineraries find a full leg; afterwards the seats sold must equal the
+// legs of the successful ones.
+long long runItineraryBenchmark(ostream &os, int flightCount, int itineraries)
+{
+    Benchmark bench(os, 5);
+    vector<vector<int>> plans = connectingPlans(bench.rng, flightCount, itineraries);
+    long long legsRequested = 0;
+    for (int i = 0; i < itineraries; ++i)
+        legsRequested += plans[i].size();
+    int seats = max(1LL, legsRequested * 3 / 4 / flightCount);
+
+    int cores = max(1u, thread::hardware_concurrency());
+    os << left << setw(10) << "Threads" << setw(20) << "Per-flight (it/s)" << setw(20) << "Global lock (it/s)"
+         << setw(10) << "Booked" << "Audit\n";
+    for (int threads = 1;; threads = min(cores, threads * 2))
+    {
+        double rate[2];
+        long long booked = 0;
+        bool consistent = true;
+        for (int global = 0; global < 2; ++global)
+        {
+            AirlinesSystem sys(bench.quiet);
+            sys.setMetricsRecording(false);
+            addConnectingFlights(sys, "B", flightCount, seats);
+            sys.registerPassenger("bench", "pw", "Bench");
+
+            mutex coarse;
+            vector<long long> legsBooked(threads, 0), itinerariesBooked(threads, 0);
+            vector<thread> workers;
+            bench.startTimer();
+            for (int t = 0; t < threads; ++t)
+                workers.push_back(thread([&, t]()
+                                         {
+                    vector<int> seatNos;
+                    for (int i = t; i < itineraries; i += threads)
+                    {
+                        bool ok;
+                        if (global)
+                        {
+                            lock_guard<mutex> guard(coarse);
+                            ok = sys.reserveItinerary("bench", plans[i], seatNos);
+                        }
+                        else
+                            ok = sys.reserveItinerary("bench", plans[i], seatNos);
+                        if (ok)
+                        {
+                            legsBooked[t] += plans[i].size();
+                            itinerariesBooked[t]++;
+                        }
+                    } }));
+            for (size_t t = 0; t < workers.size(); ++t)
+                workers[t].join();
+            rate[global] = itineraries / bench.elapsed();
+            long long legs = 0;
+            booked = 0;
+            for (int t = 0; t < threads; ++t)
+            {
+                legs += legsBooked[t];
+                booked += itinerariesBooked[t];
+            }
+            consistent = consistent && legs == sys.seatsSold();
+        }
+        os << left << setw(10) << threads << setw(20) << fixed << setprecision(0) << rate[0]
+           << setw(20) << rate[1] << setw(10) << booked << bench.audit(consistent) << "\n";
+        if (threads == cores)
+            break;
+    }
+    return bench.failures();
+}
+
+// Drives a search/book/cancel mix through the router with one client thread
+// per shard, as the shard count doubles up to eight. Clients pick flights
+// at random, so they meet on the same shard less often as shards grow.
+long long runShardBenchmark(ostream &os, int flightCount, int operations)
+{
+    Benchmark bench(os, 3);
+    uniform_int_distribution<int> airport(0, 63);
+    vector<pair<string, string>> legs;
+    for (int i = 0; i < flightCount; ++i)
+    {
+        int a = airport(bench.rng), b = airport(bench.rng);
+        if (a == b)
+            b = (b + 1) % 64;
+        legs.push_back(make_pair("S" + to_string(a), "S" + to_string(b)));
+    }
+
+    os << left << setw(10) << "Shards" << setw(16) << "Ops/s" << "Speedup\n";
+    double single = 0;
+    for (int shardCount = 1; shardCount <= 8; shardCount *= 2)
+    {
+        ShardRouter router(shardCount, bench.quiet.rdbuf());
+        router.setMetricsRecording(false);
+        vector<int> ids;
+        for (int i = 0; i < flightCount; ++i)
+            ids.push_back(router.addFlight(legs[i].first, legs[i].second, 480, 600, 200, 4000));
+        for (int t = 0; t < shardCount; ++t)
+            router.registerPassenger("client" + to_string(t), "pw", "Client");
+
+        vector<thread> clients;
+        bench.startTimer();
+        for (int t = 0; t < shardCount; ++t)
+            clients.push_back(thread([&, t]()
+                                     {
+                mt19937 local(100 + t);
+                uniform_int_distribution<int> pickFlight(0, flightCount - 1), pickOp(0, 99);
+                string user = "client" + to_string(t);
+                for (int i = t; i < operations; i += shardCount)
+                {
+                    int f = pickFlight(local), op = pickOp(local);
+                    if (op < 60)
+                        router.searchFlights(legs[f].first, legs[f].second);
+                    else if (op < 85)
+                        router.bookFlight(user, ids[f]);
+                    else
+                        router.cancelBooking(user, ids[f]);
+                } }));
+        for (size_t t = 0; t < clients.size(); ++t)
+            clients[t].join();
+        double rate = operations / bench.elapsed();
+        if (shardCount == 1)
+            single = rate;
+        os << left << setw(10) << shardCount << setw(16) << fixed << setprecision(0) << rate
+           << setprecision(2) << rate / single << "x\n";
+    }
+    os << "(" << thread::hardware_concurrency() << " hardware threads available)\n";
+    return bench.failures();
+}
+
+// Filters a synthetic crew for random flight requirements twice: with role
+// and qualification strings per member, as crew used to be stored, and with
+// the packed CrewRoster. Both must find the same crew.
+long long runCrewFilterBenchmark(ostream &os, int crewCount, int queries)
+{
+    const char *names[] = {"A320", "A321", "B737", "B787", "A330", "ATR72", "Q400", "E190",
+                           "base:DEL", "base:MUM", "base:BLR", "base:MAA", "base:CCU", "base:HYD",
+                           "lang:Hindi", "lang:Tamil", "lang:Bengali", "lang:Telugu", "lang:Kannada",
+                           "lang:Malayalam", "lang:French", "lang:Arabic"};
+    const int qualificationCount = sizeof(names) / sizeof(names[0]);
+    const char *roles[] = {"Pilot", "Co-Pilot", "Attendant"};
+    struct StringCrew
+    {
+        int id;
+        string role;
+        vector<string> qualifications;
+    };
+
+    Benchmark bench(os, 9);
+    mt19937 &rng = bench.rng;
+    uniform_int_distribution<int> pickRole(0, 2), pickQualification(0, qualificationCount - 1), coin(0, 9);
+    vector<StringCrew> legacy;
+    CrewRoster roster;
+    for (int i = 0; i < crewCount; ++i)
+    {
+        StringCrew c = {i + 1, roles[pickRole(rng)], vector<string>()};
+        uint64_t mask = 0;
+        for (int q = 0; q < qualificationCount; ++q)
+            if (coin(rng) < 3)
+            {
+                c.qualifications.push_back(names[q]);
+                mask |= 1ULL << q;
+            }
+        roster.add(c.id, parseCrewRole(c.role), mask);
+        legacy.push_back(c);
+    }
+    vector<pair<bool, vector<int>>> requests; // flight deck?, required qualification indices
+    for (int i = 0; i < queries; ++i)
+    {
+        vector<int> required;
+        for (int k = coin(rng) % 3; k >= 0; --k)
+            required.push_back(pickQualification(rng));
+        requests.push_back(make_pair(i % 2 == 0, required));
+    }
+
+    vector<size_t> expected(queries);
+    bench.startTimer();
+    for (int i = 0; i < queries; ++i)
+    {
+        vector<int> found;
+        for (size_t m = 0; m < legacy.size(); ++m)
+        {
+            const StringCrew &c = legacy[m];
+            bool deck = c.role == "Pilot" || c.role == "Co-Pilot";
+            if (deck != requests[i].first)
+                continue;
+            bool ok = true;
+            for (size_t r = 0; r < requests[i].second.size() && ok; ++r)
+                ok = find(c.qualifications.begin(), c.qualifications.end(), names[requests[i].second[r]]) != c.qualifications.end();
+            if (ok)
+                found.push_back(c.id);
+        }
+        expected[i] = found.size();
+    }
+    double stringUs = bench.elapsed() * 1e6 / queries;
+
+    int mismatches = 0;
+    vector<int> found;
+    bench.startTimer();
+    for (int i = 0; i < queries; ++i)
+    {
+        uint64_t required = 0;
+        for (size_t r = 0; r < requests[i].second.size(); ++r)
+            required |= 1ULL << requests[i].second[r];
+        roster.filter(requests[i].first ? FLIGHT_DECK_ROLES : CABIN_ROLES, required, found);
+        mismatches += found.size() != expected[i];
+    }
+    double packedUs = bench.elapsed() * 1e6 / queries;
+
+    os << fixed << setprecision(2);
+    os << "String compare: " << stringUs << " us/query\n";
+    os << "Packed bitmask: " << packedUs << " us/query (x" << stringUs / max(packedUs, 1e-3) << ")\n";
+    bench.reportMismatches(mismatches);
+    return bench.failures();
+}
+
+// Runs a mix of random composite queries over a synthetic schedule with
+// queryFlights' engine and with a plain loop over the flights that compares
+// airport strings and recomputes every fare. Both must agree.
+long long runFlightQueryBenchmark(ostream &os, int flightCount, int queries)
+{
+    const char *airports[] = {"DEL", "BOM", "BLR", "MAA", "CCU", "HYD", "AMD", "PNQ", "GOI", "COK",
+                              "JAI", "LKO", "PAT", "BBI", "GAU", "IXC", "SXR", "TRV", "IXB", "VNS"};
+    const int airportCount = sizeof(airports) / sizeof(airports[0]);
+    Benchmark bench(os, 11);
+    mt19937 &rng = bench.rng;
+    uniform_int_distribution<int> pickAirport(0, airportCount - 1), pickTime(0, 1339), pickLength(60, 240);
+    uniform_int_distribution<int> pickSeats(60, 180), pickPrice(2000, 12000), pickWindow(60, 360);
+
+    AirlinesSystem sys(bench.quiet);
+    sys.setMetricsRecording(false);
+    vector<Flight> legacy;
+    for (int i = 0; i < flightCount; ++i)
+    {
+        int s = pickAirport(rng), d = (s + 1 + pickAirport(rng) % (airportCount - 1)) % airportCount;
+        int dep = pickTime(rng), arr = dep + pickLength(rng), seats = pickSeats(rng), price = pickPrice(rng);
+        int id = sys.addFlight(airports[s], airports[d], dep, arr, seats, price);
+        legacy.push_back(Flight(id, airports[s], airports[d], dep, arr, seats, price));
+        // Sell part of the cabin so seat counts and fares vary
+        int sold = uniform_int_distribution<int>(0, seats)(rng);
+        if (sold > 0)
+            sys.bookGroup("filler", id, sold);
+        legacy.back().seatsAvailable = seats - sold;
+    }
+
+    // Thirds: one route in a departure window, any route under a fare in a
+    // window, and everything from one airport with a few free seats
+    vector<FlightQuery> mix(queries);
+    for (int i = 0; i < queries; ++i)
+    {
+        FlightQuery &q = mix[i];
+        q.departFrom = pickTime(rng);
+        q.departTo = q.departFrom + pickWindow(rng);
+        if (i % 3 != 1)
+            q.source = airports[pickAirport(rng)];
+        if (i % 3 == 0)
+            q.destination = airports[pickAirport(rng)];
+        if (i % 3 == 1)
+            q.maxPrice = pickPrice(rng);
+        else
+            q.minSeats = 1 + pickWindow(rng) % 10;
+        if (i % 3 == 2)
+            q.departFrom = numeric_limits<int>::min(), q.departTo = numeric_limits<int>::max();
+    }
+
+    vector<vector<int>> expected(queries);
+    bench.startTimer();
+    for (int i = 0; i < queries; ++i)
+    {
+        const FlightQuery &q = mix[i];
+        vector<const Flight *> found;
+        for (size_t k = 0; k < legacy.size(); ++k)
+        {
+            const Flight &f = legacy[k];
+            if ((q.source.empty() || f.source == q.source) && (q.destination.empty() || f.destination == q.destination) &&
+                f.departureTime >= q.departFrom && f.departureTime <= q.departTo &&
+                f.arrivalTime >= q.arriveFrom && f.arrivalTime <= q.arriveTo && f.seatsAvailable >= q.minSeats &&
+                (q.maxPrice <= 0 || llround(dynamicPrice(f) * 100) <= floor(q.maxPrice * 100)))
+                found.push_back(&f);
+        }
+        stable_sort(found.begin(), found.end(), [](const Flight *a, const Flight *b)
+                    { return a->departureTime < b->departureTime; });
+        for (size_t k = 0; k < found.size(); ++k)
+            expected[i].push_back(found[k]->flightID);
+    }
+    double loopUs = bench.elapsed() * 1e6 / queries;
+
+    sys.matchFlights(mix[0]); // builds the columns outside the timed loop
+    int mismatches = 0;
+    long long matches = 0;
+    bench.startTimer();
+    for (int i = 0; i < queries; ++i)
+    {
+        vector<int> ids = sys.matchFlights(mix[i]);
+        matches += ids.size();
+        mismatches += ids != expected[i];
+    }
+    double engineUs = bench.elapsed() * 1e6 / queries;
+
+    os << fixed << setprecision(2);
+    os << "Flights: " << flightCount << ", average matches: " << (double)matches / queries << "\n";
+    os << "Loop over flights: " << loopUs << " us/query\n";
+    os << "Query engine: " << engineUs << " us/query (x" << loopUs / max(engineUs, 1e-3) << ")\n";
+    bench.reportMismatches(mismatches);
+    return bench.failures();
+}
+
+// Books itineraries from writer threads while reader threads total the
+// seats sold over and over, first reading snapshots, then with readers
+// and writers sharing one lock as direct reads of the schedule would need.
+// Bookings only add seats, so each reader's totals must never go down.
+long long runSnapshotReadBenchmark(ostream &os, int flightCount, int itineraries)
+{
+    Benchmark bench(os, 17);
+    vector<vector<int>> plans = connectingPlans(bench.rng, flightCount, itineraries);
+    int cores = max(1u, thread::hardware_concurrency());
+    int writers = max(1, cores / 2), readers = max(1, cores - writers);
+
+    os << "Writers: " << writers << ", readers: " << readers << "\n";
+    os << left << setw(14) << "Reads" << setw(18) << "Bookings/s" << setw(14) << "Scans/s" << "Audit\n";
+    for (int global = 0; global < 2; ++global)
+    {
+        AirlinesSystem sys(bench.quiet);
+        sys.setMetricsRecording(false);
+        addConnectingFlights(sys, "S", flightCount, 1000);
+        sys.registerPassenger("bench", "pw", "Bench");
+
+        mutex coarse;
+        atomic<bool> done(false);
+        vector<long long> legsBooked(writers, 0), scans(readers, 0);
+        vector<char> monotonic(readers, 1);
+        vector<thread> threads;
+        bench.startTimer();
+        for (int t = 0; t < readers; ++t)
+            threads.push_back(thread([&, t]()
+                                     {
+                long long last = 0;
+                while (!done.load())
+                {
+                    long long sold;
+                    if (global)
+                    {
+                        lock_guard<mutex> guard(coarse);
+                        sold = sys.seatsSold();
+                    }
+                    else
+                        sold = sys.readView()->seatsSold();
+                    monotonic[t] &= sold >= last;
+                    last = sold;
+                    scans[t]++;
+                } }));
+        vector<thread> booking;
+        for (int t = 0; t < writers; ++t)
+            booking.push_back(thread([&, t]()
+                                     {
+                vector<int> seatNos;
+                for (int i = t; i < itineraries; i += writers)
+                {
+                    bool ok;
+                    if (global)
+                    {
+                        lock_guard<mutex> guard(coarse);
+                        ok = sys.reserveItinerary("bench", plans[i], seatNos);
+                    }
+                    else
+                        ok = sys.reserveItinerary("bench", plans[i], seatNos);
+                    if (ok)
+                        legsBooked[t] += plans[i].size();
+                } }));
+        for (size_t t = 0; t < booking.size(); ++t)
+            booking[t].join();
+        double seconds = bench.elapsed();
+        done.store(true);
+        for (size_t t = 0; t < threads.size(); ++t)
+            threads[t].join();
+
+        long long legs = 0, totalScans = 0;
+        bool consistent = sys.readView()->seatsSold() == sys.seatsSold();
+        for (int t = 0; t < writers; ++t)
+            legs += legsBooked[t];
+        for (int t = 0; t < readers; ++t)
+        {
+            totalScans += scans[t];
+            consistent = consistent && monotonic[t];
+        }
+        consistent = consistent && legs == sys.seatsSold();
+        os << left << setw(14) << (global ? "Global lock" : "Snapshot") << setw(18) << fixed << setprecision(0)
+           << itineraries / seconds << setw(14) << totalScans / seconds << bench.audit(consistent) << "\n";
+    }
+    return bench.failures();
+}
+
+// ---------------------- Main Menu ----------------------
+void adminMenu(AirlinesSystem &sys)
+{
+    while (true)
+    {
+        cout << "\n--- Admin Menu ---\n";
         cout << "1. Add Flight\n2. Remove Flight\n3. Update Flight\n4. List Flights\n";
         cout << "5. Add Crew\n6. Assign Crew\n7. List Crew\n";
         cout << "8. Flight Occupancy Report\n9. Waitlist Report\n";
-        cout << "10.View All Duties\n11.Check Crew Vaccancy \n 0. Logout\n";
+        cout << "10.View All Duties\n11.Check Crew Vaccancy \n12.Set Airport Location\n13.Route Search Benchmark\n";
+        cout << "14.Enable/Disable Route Index\n15.Route Index Report\n16.Enable/Disable All-Pairs Table\n17.Batch Route Benchmark\n18.Performance Metrics\n19.Start/Stop Trace Recording\n20.Set Seat Hold TTL\n21.Group Booking Benchmark\n22.Itinerary Booking Benchmark\n23.Sharded Throughput Benchmark\n24.Add Crew Qualification\n25.Set Flight Crew Requirements\n26.Crew Filter Benchmark\n27.Flight Query Benchmark\n28.Delay Flight\n29.Snapshot Read Benchmark\n 0. Logout\n";
+        int ch;
+        cin >> ch;
+        if (ch == 0)
+            break;
+        if (ch == 1)
+        {
+            int a;
+            cout << "Tell Me Captain ! 😉 How many Flights are we Adding to The Runway? :  ";
+            cin >> a;
+            int n = 1;
+            while (a--)
+            {
+                cout << "Enter Details of Flight No. " << n << endl;
+                n++;
+                string src, dest;
+                int dep, arr, seats;
+                double price;
+                cout << "Source: ";
+                cin >> src;
+                cout << "Destination: ";
+                cin >> dest;
+                cout << "Departure (min from midnight): ";
+                cin >> dep;
+                cout << "Arrival (min from midnight): ";
+                cin >> arr;
+                cout << "Seats: ";
+                cin >> seats;
+                cout << "Base Price: ";
+                cin >> price;
+                sys.addFlight(src, dest, dep, arr, seats, price);
+            }
+        }
+        else if (ch == 2)
+        {
+            int a;
+            cout << "Captain, how many flights are we clearing for deletion?";
+            cin >> a;
+            int n = 1;
+            while (a--)
+            {
+                int fid;
+                cout << "Flight ID: ";
+                cin >> fid;
+                sys.removeFlight(fid);
+                cout << "Off the list, out of sight — say goodbye to this flight!" << endl;
+            }
+        }
+        else if (ch == 3)
+        {
+            int fid, dep, arr, seats;
+            double price;
+            cout << "Flight ID: ";
+            cin >> fid;
+            cout << "New Departure (min): ";
+            cin >> dep;
+            cout << "New Arrival (min): ";
+            cin >> arr;
+            cout << "New Seats: ";
+            cin >> seats;
+            cout << "New Base Price: ";
+            cin >> price;
+            sys.updateFlight(fid, dep, arr, seats, price);
+        }
+        else if (ch == 4)
+        {
+            sys.listFlights();
+        }
+        else if (ch == 5)
+        {
+            int a;
+            cout << "How many new faces are joining the flight crew?" << endl;
+            cin >> a;
+            while (a--)
+            {
+                string name, role;
+                cout << "Crew Name: ";
+                cin >> name;
+                cout << "Role (Pilot/Co-Pilot/Attendant): ";
+                cin >> role;
+                if (sys.addCrew(name, role))
+                    cout << name << " is now taking on the role of " << role << " for FlightEase. Let us  all welcome " << name << "to the FlightEase family!" << endl;
+            }
+        }
+        else if (ch == 6)
+        {
+            sys.assignCrewToAllFlights();
+        }
+        else if (ch == 7)
+        {
+            sys.listCrew();
+        }
+        else if (ch == 8)
+        {
+            sys.flightOccupancyReport();
+        }
+        else if (ch == 9)
+        {
+            sys.waitlistReport();
+        }
+        else if (ch == 10)
+        {
+            sys.printAllDuties();
+        }
+        else if (ch == 11)
+        {
+            sys.checkCrewVacancy();
+        }
+        else if (ch == 12)
+        {
+            string code;
+            double lat, lon;
+            cout << "Airport Code: ";
+            cin >> code;
+            cout << "Latitude: ";
+            cin >> lat;
+            cout << "Longitude: ";
+            cin >> lon;
+            sys.setAirportLocation(code, lat, lon);
+        }
+        else if (ch == 13)
+        {
+            int airports, queries;
+            cout << "Number of airports: ";
+            cin >> airports;
+            cout << "Number of queries: ";
+            cin >> queries;
+            if (airports < 2 || queries < 1)
+                cout << "Error: Need at least 2 airports and 1 query.\n";
+            else
+                runRouteBenchmark(cout, airports, queries);
+        }
+        else if (ch == 14)
+        {
+            int on;
+            cout << "Route index (1 = enable, 0 = disable): ";
+            cin >> on;
+            sys.setRouteIndexEnabled(on == 1);
+        }
+        else if (ch == 15)
+        {
+            sys.routeIndexReport();
+        }
+        else if (ch == 16)
+        {
+            int on;
+            cout << "All-pairs table (1 = enable, 0 = disable): ";
+            cin >> on;
+            sys.setDistanceTableEnabled(on == 1);
+        }
+        else if (ch == 17)
+        {
+            int airports, queries;
+            cout << "Number of airports: ";
+            cin >> airports;
+            cout << "Number of queries: ";
+            cin >> queries;
+            if (airports < 2 || queries < 1)
+                cout << "Error: Need at least 2 airports and 1 query.\n";
+            else
+                runBatchRouteBenchmark(cout, airports, queries);
+        }
+        else if (ch == 18)
+        {
+            sys.metricsReport();
+        }
+        else if (ch == 19)
+        {
+            int on;
+            string path = "flightease_trace.json";
+            cout << "Trace recording (1 = start, 0 = stop and export): ";
+            cin >> on;
+            if (on != 1)
+            {
+                cout << "Export file: ";
+                cin >> path;
+            }
+            sys.setTraceRecording(on == 1, path);
+        }
+        else if (ch == 20)
+        {
+            int seconds;
+            cout << "Hold TTL (seconds): ";
+            cin >> seconds;
+            sys.setHoldTtl(seconds);
+        }
+        else if (ch == 21)
+        {
+            int seats;
+            cout << "Seats per flight: ";
+            cin >> seats;
+            if (seats < 5)
+                cout << "Error: Need at least 5 seats.\n";
+            else
+                runGroupBookingBenchmark(cout, seats, 20);
+        }
+        else if (ch == 22)
+        {
+            int flightCount, itineraries;
+            cout << "Number of flights: ";
+            cin >> flightCount;
+            cout << "Number of itineraries: ";
+            cin >> itineraries;
+            if (flightCount < 3 || itineraries < 1)
+                cout << "Error: Need at least 3 flights and 1 itinerary.\n";
+            else
+                runItineraryBenchmark(cout, flightCount, itineraries);
+        }
+        else if (ch == 23)
+        {
+            int flightCount, operations;
+            cout << "Number of flights: ";
+            cin >> flightCount;
+            cout << "Number of operations: ";
+            cin >> operations;
+            if (flightCount < 1 || operations < 1)
+                cout << "Error: Need at least 1 flight and 1 operation.\n";
+            else
+                runShardBenchmark(cout, flightCount, operations);
+        }
+        else if (ch == 24)
+        {
+            int cid;
+            string qualification;
+            cout << "Crew ID: ";
+            cin >> cid;
+            cout << "Qualification (e.g. A320, base:DEL, lang:Tamil): ";
+            cin >> qualification;
+            sys.qualifyCrew(cid, qualification);
+        }
+        else if (ch == 25)
+        {
+            int fid, count;
+            cout << "Flight ID: ";
+            cin >> fid;
+            cout << "Number of required qualifications (0 to clear): ";
+            cin >> count;
+            vector<string> required;
+            for (int i = 0; i < count; ++i)
+            {
+                string q;
+                cout << "Qualification " << i + 1 << ": ";
+                cin >> q;
+                required.push_back(q);
+            }
+            sys.setCrewRequirements(fid, required);
+        }
+        else if (ch == 26)
+        {
+            int crewCount, queries;
+            cout << "Number of crew: ";
+            cin >> crewCount;
+            cout << "Number of queries: ";
+            cin >> queries;
+            if (crewCount < 1 || queries < 1)
+                cout << "Error: Need at least 1 crew member and 1 query.\n";
+            else
+                runCrewFilterBenchmark(cout, crewCount, queries);
+        }
+        else if (ch == 27)
+        {
+            int flightCount, queries;
+            cout << "Number of flights: ";
+            cin >> flightCount;
+            cout << "Number of queries: ";
+            cin >> queries;
+            if (flightCount < 1 || queries < 1)
+                cout << "Error: Need at least 1 flight and 1 query.\n";
+            else
+                runFlightQueryBenchmark(cout, flightCount, queries);
+        }
+        else if (ch == 28)
+        {
+            int fid, depDelay, arrDelay;
+            cout << "Flight ID: ";
+            cin >> fid;
+            cout << "Departure delay (min, negative if earlier): ";
+            cin >> depDelay;
+            cout << "Arrival delay (min): ";
+            cin >> arrDelay;
+            sys.delayFlight(fid, depDelay, arrDelay);
+        }
+        else if (ch == 29)
+        {
+            int flightCount, itineraries;
+            cout << "Number of flights: ";
+            cin >> flightCount;
+            cout << "Number of itineraries: ";
+            cin >> itineraries;
+            if (flightCount < 3 || itineraries < 1)
+                cout << "Error: Need at least 3 flights and 1 itinerary.\n";
+            else
+                runSnapshotReadBenchmark(cout, flightCount, itineraries);
+        }
+    }
+}
+
+void passengerMenu(AirlinesSystem &sys, string username)
+{
+    while (true)
+    {
+        cout << "\n--- Passenger Menu ---\n";
+        cout << "1. Available Flights\n2. Search Flights by Route\n3. Search Flights by Time\n4. Book Flight\n";
+        cout << "5. Cancel Booking\n6. My Bookings\n7. Find Shortest Route\n8.Find Cheapest Route\n9. Where Can I Go?\n";
+        cout << "10.Hold Seat\n11.Confirm Hold\n12.Release Hold\n13.Group Booking\n14.Book Itinerary\n15.Find Flights\n0. Logout\n";
         int ch;
         cin >> ch;
         if (ch == 0)
             break;
         if (ch == 1)
         {
-            int a;
-            cout << "Tell Me Captain ! 😉 How many Flights are we Adding to The Runway? :  ";
-            cin >> a;
-            int n = 1;
-            while (a--)
+            sys.listFlights();
+        }
+        if (ch == 2)
+        {
+            string src, dest;
+            cout << "Source: ";
+            cin >> src;
+            cout << "Destination: ";
+            cin >> dest;
+            sys.searchFlights(src, dest);
+        }
+        else if (ch == 3)
+        {
+            int dep1, dep2;
+            cout << "Earliest Departure (min): ";
+            cin >> dep1;
+            cout << "Latest Departure (min): ";
+            cin >> dep2;
+            sys.searchFlightsByTime(dep1, dep2);
+        }
+        else if (ch == 4)
+        {
+            int fid;
+            cout << "Flight ID to book: ";
+            cin >> fid;
+            sys.bookFlight(username, fid);
+        }
+        else if (ch == 5)
+        {
+            int fid;
+            cout << "Flight ID to cancel: ";
+            cin >> fid;
+            sys.cancelBooking(username, fid);
+        }
+        else if (ch == 6)
+        {
+            sys.listPassengerBookings(username);
+        }
+        else if (ch == 7)
+        {
+            string src, dest;
+            cout << "Source: ";
+            cin >> src;
+            cout << "Destination: ";
+            cin >> dest;
+            sys.findShortestRoute(src, dest);
+        }
+        else if (ch == 8)
+        {
+            string src, dest;
+            cout << "Source: ";
+            cin >> src;
+            cout << "Destination: ";
+            cin >> dest;
+            sys.findCheapestRoute(src, dest);
+        }
+        else if (ch == 9)
+        {
+            string src;
+            int by, limit;
+            cout << "Source: ";
+            cin >> src;
+            cout << "Limit by (1 = travel time, 2 = budget): ";
+            cin >> by;
+            cout << (by == 2 ? "Budget (INR): " : "Max travel time (min): ");
+            cin >> limit;
+            sys.reachableFrom(src, limit, by == 2);
+        }
+        else if (ch == 10)
+        {
+            int fid;
+            cout << "Flight ID to hold: ";
+            cin >> fid;
+            sys.holdSeat(username, fid);
+        }
+        else if (ch == 11 || ch == 12)
+        {
+            long long hid;
+            cout << "Hold ID: ";
+            cin >> hid;
+            if (ch == 11)
+                sys.confirmHold(username, hid);
+            else
+                sys.releaseHold(username, hid);
+        }
+        else if (ch == 13)
+        {
+            int fid, party;
+            cout << "Flight ID to book: ";
+            cin >> fid;
+            cout << "Number of seats: ";
+            cin >> party;
+            sys.bookGroup(username, fid, party);
+        }
+        else if (ch == 14)
+        {
+            string src, dest;
+            int by;
+            cout << "Enter source: ";
+            cin >> src;
+            cout << "Enter destination: ";
+            cin >> dest;
+            cout << "1. Fastest  2. Cheapest: ";
+            cin >> by;
+            sys.bookRoute(username, src, dest, by == 2);
+        }
+        else if (ch == 15)
+        {
+            FlightQuery q;
+            int by;
+            cout << "Source (- for any): ";
+            cin >> q.source;
+            cout << "Destination (- for any): ";
+            cin >> q.destination;
+            if (q.source == "-")
+                q.source.clear();
+            if (q.destination == "-")
+                q.destination.clear();
+            cout << "Earliest Departure (min): ";
+            cin >> q.departFrom;
+            cout << "Latest Departure (min): ";
+            cin >> q.departTo;
+            cout << "Minimum free seats: ";
+            cin >> q.minSeats;
+            cout << "Max price (0 for any): ";
+            cin >> q.maxPrice;
+            cout << "Sort by (1 = departure, 2 = arrival, 3 = price, 4 = duration, 5 = seats): ";
+            cin >> by;
+            q.sortBy = (FlightSortKey)max(0, min(4, by - 1));
+            cout << "Show at most (0 for all): ";
+            cin >> q.limit;
+            sys.queryFlights(q);
+        }
+    }
+}
+
+// Preload some flights
+void loadDefaultSchedule(AirlinesSystem &sys)
+{
+    sys.addFlight("DEL", "MUM", 480, 660, 3, 5000);
+    sys.addFlight("MUM", "BLR", 700, 900, 2, 4000);
+    sys.addFlight("DEL", "BLR", 500, 900, 1, 7000);
+}
+
+// ---------------------- Request Server ----------------------
+// Serves AirlinesSystem to a front end (e.g. the booking website) over TCP on
+// localhost or a Unix socket. Requests are single lines ("BOOK alice 1000");
+// each response is "<length>\n" followed by that many bytes of the text the
+// operation would print on the console. Clients may pipeline any number of
+// requests; responses come back in order. One epoll loop serves every
+// connection, so operations never run concurrently.
+#ifdef __linux__
+const char *SERVER_HELP =
+    "PING | LIST | SEARCH src dest | SEARCHTIME from to | ROUTE src dest | CHEAPEST src dest\n"
+    "REACH src limit [time|price] | REGISTER user pass name | BOOK user flightID\n"
+    "CANCEL user flightID | BOOKINGS user | HOLD user flightID | CONFIRM user holdID\n"
+    "RELEASE user holdID | GROUP user flightID seats | ITINERARY user src dest [time|price]\n"
+    "FIND [from=src] [to=dest] [dep=lo-hi] [arr=lo-hi] [seats=n] [maxprice=p]\n"
+    "     [sort=departure|arrival|price|duration|seats] [desc] [limit=n] | METRICS\n";
+
+// Set by SIGINT/SIGTERM so the server returns and flushes its logs on the way out
+volatile sig_atomic_t stopRequested = 0;
+
+void requestStop(int)
+{
+    stopRequested = 1;
+}
+
+// Opens a non-blocking listening or connected socket for "port" (TCP on
+// 127.0.0.1) or "/path" (Unix socket); returns -1 on failure
+int openEndpoint(const string &endpoint, bool listening)
+{
+    bool unixSocket = endpoint.find('/') != string::npos;
+    int fd = socket(unixSocket ? AF_UNIX : AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+    int rc;
+    if (unixSocket)
+    {
+        sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, endpoint.c_str(), sizeof(addr.sun_path) - 1);
+        if (listening)
+        {
+            unlink(endpoint.c_str());
+            rc = ::bind(fd, (sockaddr *)&addr, sizeof(addr));
+        }
+        else
+            rc = connect(fd, (sockaddr *)&addr, sizeof(addr));
+    }
+    else
+    {
+        sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(atoi(endpoint.c_str()));
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        int one = 1;
+        if (listening)
+        {
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+            rc = ::bind(fd, (sockaddr *)&addr, sizeof(addr));
+        }
+        else
+        {
+            rc = connect(fd, (sockaddr *)&addr, sizeof(addr));
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        }
+    }
+    if (rc == 0 && listening)
+        rc = listen(fd, 512);
+    if (rc != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    return fd;
+}
+
+class RequestServer
+{
+public:
+    RequestServer(AirlinesSystem &s) : sys(s), listener(-1), epollFd(-1), served(0) {}
+
+    int run(const string &endpoint)
+    {
+        signal(SIGPIPE, SIG_IGN);
+        signal(SIGINT, requestStop);
+        signal(SIGTERM, requestStop);
+        listener = openEndpoint(endpoint, true);
+        if (listener < 0)
+        {
+            cerr << "Could not listen on " << endpoint << ": " << strerror(errno) << endl;
+            return 1;
+        }
+        epollFd = epoll_create1(0);
+        watch(listener, EPOLLIN, EPOLL_CTL_ADD);
+        cerr << "Serving on " << endpoint << " (Ctrl+C to stop)\n";
+
+        vector<epoll_event> events(256);
+        while (!stopRequested)
+        {
+            int ready = epoll_wait(epollFd, events.data(), events.size(), -1);
+            if (ready < 0 && errno != EINTR)
+                break;
+            for (int i = 0; i < ready; ++i)
             {
-                cout << "Enter Details of Flight No. " << n << endl;
-                n++;
-                string src, dest;
-                int dep, arr, seats;
-                double price;
-                cout << "Source: ";
-                cin >> src;
-                cout << "Destination: ";
-                cin >> dest;
-                cout << "Departure (min from midnight): ";
-                cin >> dep;
-                cout << "Arrival (min from midnight): ";
-                cin >> arr;
-                cout << "Seats: ";
-                cin >> seats;
-                cout << "Base Price: ";
-                cin >> price;
-                sys.addFlight(src, dest, dep, arr, seats, price);
+                int fd = events[i].data.fd;
+                if (fd == listener)
+                    acceptAll();
+                else
+                    service(fd, events[i].events);
             }
         }
-        else if (ch == 2)
+        return 0;
+    }
+
+private:
+    struct Connection
+    {
+        string in, out;
+        size_t sent = 0;
+        uint32_t watching = EPOLLIN;
+        bool closing = false; // nothing more will be read; close once `out` is sent
+    };
+    // Longest request line; a client that sends more without a newline is cut off
+    static const size_t MAX_REQUEST_BYTES = 64 * 1024;
+
+    AirlinesSystem &sys;
+    int listener, epollFd;
+    unordered_map<int, Connection> connections;
+    // Reused for every request so a warmed-up server allocates nothing per request
+    string line, body, cmd, a, b;
+    StringSink capture{body};
+    istringstream req;
+    long long served;
+    uint64_t allocations = 0; // heap allocations while answering, all requests
+
+    void watch(int fd, uint32_t events, int op)
+    {
+        epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = events;
+        ev.data.fd = fd;
+        epoll_ctl(epollFd, op, fd, &ev);
+    }
+
+    void acceptAll()
+    {
+        while (true)
         {
-            int a;
-            cout << "Captain, how many flights are we clearing for deletion?";
-            cin >> a;
-            int n = 1;
-            while (a--)
+            int fd = accept(listener, NULL, NULL);
+            if (fd < 0)
+                return;
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            connections[fd] = Connection();
+            watch(fd, EPOLLIN, EPOLL_CTL_ADD);
+        }
+    }
+
+    void drop(int fd)
+    {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, NULL);
+        close(fd);
+        connections.erase(fd);
+    }
+
+    void service(int fd, uint32_t events)
+    {
+        unordered_map<int, Connection>::iterator it = connections.find(fd);
+        if (it == connections.end())
+            return;
+        Connection &c = it->second;
+        if (events & EPOLLERR)
+        {
+            drop(fd);
+            return;
+        }
+        // A hang-up can still leave requests to read; they are answered first
+        if ((events & (EPOLLIN | EPOLLHUP)) && !c.closing)
+        {
+            char buf[16384];
+            while (!c.closing)
             {
-                int fid;
-                cout << "Flight ID: ";
-                cin >> fid;
-                sys.removeFlight(fid);
-                cout << "Off the list, out of sight — say goodbye to this flight!" << endl;
+                ssize_t n = read(fd, buf, sizeof(buf));
+                if (n > 0)
+                {
+                    c.in.append(buf, n);
+                    answerLines(c);
+                }
+                else if (n == 0)
+                    c.closing = true;
+                else if (errno != EAGAIN && errno != EWOULDBLOCK)
+                {
+                    drop(fd);
+                    return;
+                }
+                else
+                    break;
             }
         }
-        else if (ch == 3)
+        flush(fd, c);
+    }
+
+    // Answers every complete request in the buffer (pipelining)
+    void answerLines(Connection &c)
+    {
+        size_t start = 0, end;
+        while ((end = c.in.find('\n', start)) != string::npos)
         {
-            int fid, dep, arr, seats;
-            double price;
-            cout << "Flight ID: ";
-            cin >> fid;
-            cout << "New Departure (min): ";
-            cin >> dep;
-            cout << "New Arrival (min): ";
-            cin >> arr;
-            cout << "New Seats: ";
-            cin >> seats;
-            cout << "New Base Price: ";
-            cin >> price;
-            sys.updateFlight(fid, dep, arr, seats, price);
+            line.assign(c.in, start, end - start);
+            if (!line.empty() && line[line.size() - 1] == '\r')
+                line.erase(line.size() - 1);
+            respond(c.out);
+            start = end + 1;
+        }
+        c.in.erase(0, start);
+        if (c.in.size() > MAX_REQUEST_BYTES)
+        {
+            c.out += "21\nERR request too long\n";
+            c.in.clear();
+            c.closing = true;
+        }
+    }
+
+    void flush(int fd, Connection &c)
+    {
+        while (c.sent < c.out.size())
+        {
+            ssize_t n = write(fd, c.out.data() + c.sent, c.out.size() - c.sent);
+            if (n <= 0)
+            {
+                if (errno != EAGAIN && errno != EWOULDBLOCK)
+                {
+                    drop(fd);
+                    return;
+                }
+                break;
+            }
+            c.sent += n;
+        }
+        if (c.sent == c.out.size())
+        {
+            c.out.clear();
+            c.sent = 0;
+        }
+        if (c.closing && c.out.empty())
+        {
+            drop(fd);
+            return;
+        }
+        uint32_t wanted = (c.closing ? 0 : (uint32_t)EPOLLIN) | (c.out.empty() ? 0 : (uint32_t)EPOLLOUT);
+        if (wanted != c.watching)
+        {
+            c.watching = wanted;
+            watch(fd, wanted, EPOLL_CTL_MOD);
+        }
+    }
+
+    void respond(string &out)
+    {
+        uint64_t before = heapAllocations();
+        body.clear();
+        streambuf *console = cout.rdbuf(&capture);
+        dispatch();
+        cout.rdbuf(console);
+        out += to_string(body.size());
+        out += '\n';
+        out += body;
+        served++;
+        allocations += heapAllocations() - before;
+    }
+
+    void dispatch()
+    {
+        req.clear();
+        req.str(line);
+        cmd.clear();
+        a.clear();
+        b.clear();
+        req >> cmd;
+        if (cmd == "PING")
+            cout << "PONG\n";
+        else if (cmd == "METRICS")
+        {
+            sys.metricsReport();
+#if FLIGHTEASE_ALLOC_COUNTERS
+            cout << "Server: " << served << " requests, " << (served ? (double)allocations / served : 0.0)
+                 << " heap allocations per request\n";
+#endif
+        }
+        else if (cmd == "LIST")
+            sys.listFlights();
+        else if (cmd == "SEARCH" && req >> a >> b)
+            sys.searchFlights(a, b);
+        else if (cmd == "SEARCHTIME" && req >> a >> b)
+            sys.searchFlightsByTime(atoi(a.c_str()), atoi(b.c_str()));
+        else if (cmd == "FIND")
+        {
+            FlightQuery q;
+            if (parseFlightQuery(req, q))
+                sys.queryFlights(q);
+            else
+                cout << "ERR bad FIND term\n";
+        }
+        else if (cmd == "ROUTE" && req >> a >> b)
+            sys.findShortestRoute(a, b);
+        else if (cmd == "CHEAPEST" && req >> a >> b)
+            sys.findCheapestRoute(a, b);
+        else if (cmd == "REACH" && req >> a >> b)
+        {
+            string by;
+            req >> by;
+            sys.reachableFrom(a, atoi(b.c_str()), by == "price");
+        }
+        else if (cmd == "REGISTER" && req >> a >> b)
+        {
+            string name;
+            getline(req >> ws, name);
+            cout << (sys.registerPassenger(a, b, name) ? "Registration successful.\n" : "Username already exists.\n");
+        }
+        else if ((cmd == "BOOK" || cmd == "GROUP" || cmd == "CANCEL" || cmd == "BOOKINGS" || cmd == "HOLD" ||
+                  cmd == "CONFIRM" || cmd == "RELEASE" || cmd == "ITINERARY") &&
+                 req >> a)
+        {
+            if (!sys.hasPassenger(a))
+                cout << "ERR unknown passenger\n";
+            else if (cmd == "BOOKINGS")
+                sys.listPassengerBookings(a);
+            else if (!(req >> b))
+                cout << "ERR missing flight or hold ID\n";
+            else if (cmd == "BOOK")
+                sys.bookFlight(a, atoi(b.c_str()));
+            else if (cmd == "GROUP")
+            {
+                int party = 0;
+                req >> party;
+                sys.bookGroup(a, atoi(b.c_str()), party);
+            }
+            else if (cmd == "ITINERARY")
+            {
+                string dest, by;
+                req >> dest >> by;
+                sys.bookRoute(a, b, dest, by == "price");
+            }
+            else if (cmd == "HOLD")
+                sys.holdSeat(a, atoi(b.c_str()));
+            else if (cmd == "CONFIRM")
+                sys.confirmHold(a, atoll(b.c_str()));
+            else if (cmd == "RELEASE")
+                sys.releaseHold(a, atoll(b.c_str()));
+            else
+                sys.cancelBooking(a, atoi(b.c_str()));
+        }
+        else
+            cout << "ERR unknown request. Commands:\n"
+                 << SERVER_HELP;
+    }
+};
+
+// Load generator: opens `connections` sockets, keeps up to `depth` requests
+// in flight on each, and reports throughput and latency percentiles.
+int runLoadGenerator(const string &endpoint, int connectionCount, int requests, int depth)
+{
+    signal(SIGPIPE, SIG_IGN);
+    struct Client
+    {
+        int fd;
+        string in, out;
+        deque<chrono::steady_clock::time_point> inflight;
+        int issued = 0;
+    };
+    vector<Client> clients(connectionCount);
+    for (int i = 0; i < connectionCount; ++i)
+    {
+        clients[i].fd = openEndpoint(endpoint, false);
+        if (clients[i].fd < 0)
+        {
+            cerr << "Could not connect to " << endpoint << ": " << strerror(errno) << endl;
+            return 1;
+        }
+    }
+
+    // Mostly reads, with a booking/cancellation pair in every ten requests
+    const char *reads[] = {"SEARCH DEL MUM", "SEARCHTIME 400 800", "ROUTE DEL BLR", "CHEAPEST DEL BLR",
+                           "REACH DEL 600 time", "SEARCH MUM BLR", "ROUTE MUM BLR", "PING"};
+    int perClient = requests / connectionCount;
+    vector<double> latencies;
+    latencies.reserve(requests + connectionCount);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    for (int i = 0; i < connectionCount; ++i)
+    {
+        clients[i].out = "REGISTER loadgen" + to_string(i) + " pw Load Generator\n";
+        clients[i].inflight.push_back(chrono::steady_clock::now());
+        clients[i].issued = -1; // registration is not counted
+    }
+
+    int active = connectionCount;
+    vector<pollfd> fds(connectionCount);
+    while (active > 0)
+    {
+        for (int i = 0; i < connectionCount; ++i)
+        {
+            Client &c = clients[i];
+            while (c.issued >= 0 && c.issued < perClient && (int)c.inflight.size() < depth)
+            {
+                string user = "loadgen" + to_string(i);
+                int slot = c.issued % 10;
+                if (slot == 8)
+                    c.out += "BOOK " + user + " 1000\n";
+                else if (slot == 9)
+                    c.out += "CANCEL " + user + " 1000\n";
+                else
+                    c.out += string(reads[(c.issued + i) % 8]) + "\n";
+                c.inflight.push_back(chrono::steady_clock::now());
+                c.issued++;
+            }
+            fds[i].fd = c.fd;
+            fds[i].events = POLLIN | (c.out.empty() ? 0 : POLLOUT);
+            fds[i].revents = 0;
+        }
+        if (poll(fds.data(), fds.size(), 5000) <= 0)
+        {
+            cerr << "Server stopped responding.\n";
+            return 1;
+        }
+        for (int i = 0; i < connectionCount; ++i)
+        {
+            Client &c = clients[i];
+            if (fds[i].revents & POLLOUT)
+            {
+                ssize_t n = write(c.fd, c.out.data(), c.out.size());
+                if (n > 0)
+                    c.out.erase(0, n);
+            }
+            if (!(fds[i].revents & (POLLIN | POLLHUP | POLLERR)))
+                continue;
+            char buf[65536];
+            ssize_t n = read(c.fd, buf, sizeof(buf));
+            if (n <= 0)
+            {
+                cerr << "Connection closed by server.\n";
+                return 1;
+            }
+            c.in.append(buf, n);
+            // Consume complete "<length>\n<body>" responses
+            while (true)
+            {
+                size_t nl = c.in.find('\n');
+                if (nl == string::npos)
+                    break;
+                size_t len = strtoul(c.in.c_str(), NULL, 10);
+                if (c.in.size() < nl + 1 + len)
+                    break;
+                c.in.erase(0, nl + 1 + len);
+                double us = chrono::duration<double, micro>(chrono::steady_clock::now() - c.inflight.front()).count();
+                c.inflight.pop_front();
+                if (c.issued < 0)
+                    c.issued = 0;
+                else
+                    latencies.push_back(us);
+            }
+            if (c.issued >= perClient && c.inflight.empty() && c.fd >= 0)
+            {
+                close(c.fd);
+                c.fd = -1;
+                active--;
+            }
+        }
+    }
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double p)
+    {
+        return latencies.empty() ? 0.0 : latencies[min(latencies.size() - 1, (size_t)(p * latencies.size()))];
+    };
+    cout << fixed << setprecision(1);
+    cout << "Requests: " << latencies.size() << " over " << connectionCount << " connection(s), pipeline depth " << depth << "\n";
+    cout << "Throughput: " << latencies.size() / seconds << " requests/s\n";
+    cout << "Latency (us): p50 " << percentile(0.50) << " | p99 " << percentile(0.99)
+         << " | p99.9 " << percentile(0.999) << " | max " << (latencies.empty() ? 0.0 : latencies.back()) << "\n";
+    return 0;
+}
+#endif
+
+// ---------------------- Call Replay ----------------------
+// Re-executes a call capture against a fresh system with its output
+// discarded, either at the recorded pacing or back to back, and reports the
+// latency of each call type. The hold clock follows the capture's own
+// timestamps, so both modes expire the same holds as the original session.
+int runReplay(const string &path, bool fast)
+{
+    CallReader in;
+    if (!in.open(path))
+    {
+        cerr << "Cannot read call capture " << path << endl;
+        return 1;
+    }
+    NullBuffer sink;
+    ostream quiet(&sink);
+    AirlinesSystem sys(quiet);
+    vector<vector<uint64_t>> histograms(CALL_CODE_END, vector<uint64_t>(LatencyHistogram::BUCKETS, 0));
+    vector<uint64_t> calls(CALL_CODE_END, 0), totalNanos(CALL_CODE_END, 0);
+    CallCode code = CALL_REGISTER;
+    uint64_t delta, traceMicros = 0, replayed = 0;
+    // Arguments are decoded first so only the call itself is timed
+    auto timed = [&](auto call)
+    {
+        chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+        call();
+        uint64_t nanos = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - t0).count();
+        calls[code]++;
+        totalNanos[code] += nanos;
+        histograms[code][LatencyHistogram::bucketOf(nanos)]++;
+    };
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    while (in.next(code, delta))
+    {
+        traceMicros += delta;
+        if (!fast)
+            this_thread::sleep_until(start + chrono::microseconds(traceMicros));
+        sys.pinClock(traceMicros / 1000);
+        switch (code)
+        {
+        case CALL_REGISTER:
+        {
+            string u = in.getString(), name = in.getString();
+            timed([&]
+                  { sys.registerPassenger(u, "", name); });
+            break;
+        }
+        case CALL_ADD_FLIGHT:
+        {
+            string src = in.getString(), dest = in.getString();
+            int dep = in.getInt(), arr = in.getInt(), seats = in.getInt();
+            double price = in.getDouble();
+            timed([&]
+                  { sys.addFlight(src, dest, dep, arr, seats, price); });
+            break;
+        }
+        case CALL_REMOVE_FLIGHT:
+        {
+            int id = in.getInt();
+            timed([&]
+                  { sys.removeFlight(id); });
+            break;
+        }
+        case CALL_UPDATE_FLIGHT:
+        {
+            int id = in.getInt(), dep = in.getInt(), arr = in.getInt(), seats = in.getInt();
+            double price = in.getDouble();
+            timed([&]
+                  { sys.updateFlight(id, dep, arr, seats, price); });
+            break;
+        }
+        case CALL_SET_LOCATION:
+        {
+            string airport = in.getString();
+            double lat = in.getDouble();
+            double lon = in.getDouble();
+            timed([&]
+                  { sys.setAirportLocation(airport, lat, lon); });
+            break;
+        }
+        case CALL_ADD_CREW:
+        {
+            string name = in.getString(), role = in.getString();
+            timed([&]
+                  { sys.addCrew(name, role); });
+            break;
+        }
+        case CALL_SEARCH:
+        {
+            string src = in.getString(), dest = in.getString();
+            timed([&]
+                  { sys.searchFlights(src, dest); });
+            break;
+        }
+        case CALL_SEARCH_TIME:
+        {
+            int from = in.getInt(), to = in.getInt();
+            timed([&]
+                  { sys.searchFlightsByTime(from, to); });
+            break;
+        }
+        case CALL_BOOK:
+        case CALL_CANCEL:
+        case CALL_HOLD:
+        {
+            string u = in.getString();
+            int id = in.getInt();
+            timed([&]
+                  {
+                if (code == CALL_BOOK)
+                    sys.bookFlight(u, id);
+                else if (code == CALL_CANCEL)
+                    sys.cancelBooking(u, id);
+                else
+                    sys.holdSeat(u, id); });
+            break;
+        }
+        case CALL_BOOK_GROUP:
+        {
+            string u = in.getString();
+            int id = in.getInt(), party = in.getInt();
+            timed([&]
+                  { sys.bookGroup(u, id, party); });
+            break;
+        }
+        case CALL_CONFIRM_HOLD:
+        case CALL_RELEASE_HOLD:
+        {
+            string u = in.getString();
+            long long hold = in.getInt();
+            timed([&]
+                  {
+                if (code == CALL_CONFIRM_HOLD)
+                    sys.confirmHold(u, hold);
+                else
+                    sys.releaseHold(u, hold); });
+            break;
+        }
+        case CALL_SET_HOLD_TTL:
+        {
+            int seconds = in.getInt();
+            timed([&]
+                  { sys.setHoldTtl(seconds); });
+            break;
+        }
+        case CALL_LIST_BOOKINGS:
+        {
+            string u = in.getString();
+            timed([&]
+                  { sys.listPassengerBookings(u); });
+            break;
+        }
+        case CALL_SHORTEST_ROUTE:
+        case CALL_CHEAPEST_ROUTE:
+        {
+            string src = in.getString(), dest = in.getString();
+            RouteSearchMode mode = (RouteSearchMode)in.getInt();
+            timed([&]
+                  {
+                if (code == CALL_SHORTEST_ROUTE)
+                    sys.findShortestRoute(src, dest, mode);
+                else
+                    sys.findCheapestRoute(src, dest, mode); });
+            break;
         }
-        else if (ch == 4)
+        case CALL_BOOK_ITINERARY:
         {
-            sys.listFlights();
+            string u = in.getString();
+            vector<int> legs = in.getInts();
+            timed([&]
+                  { sys.bookItinerary(u, legs); });
+            break;
         }
-        else if (ch == 5)
+        case CALL_BOOK_ROUTE:
         {
-            int a;
-            cout << "How many new faces are joining the flight crew?" << endl;
-            cin >> a;
-            while (a--)
-            {
-                string name, role;
-                cout << "Crew Name: ";
-                cin >> name;
-                cout << "Role (Pilot/Attendant): ";
-                cin >> role;
-                sys.addCrew(name, role);
-                cout << name << " is now taking on the role of " << role << " for FlightEase. Let us  all welcome " << name << "to the FlightEase family!" << endl;
-            }
+            string u = in.getString(), src = in.getString(), dest = in.getString();
+            bool byPrice = in.getInt() != 0;
+            timed([&]
+                  { sys.bookRoute(u, src, dest, byPrice); });
+            break;
         }
-        else if (ch == 6)
+        case CALL_REACHABLE:
         {
-            sys.assignCrewToAllFlights();
+            string src = in.getString();
+            int limit = in.getInt();
+            bool byPrice = in.getInt() != 0;
+            timed([&]
+                  { sys.reachableFrom(src, limit, byPrice); });
+            break;
         }
-        else if (ch == 7)
+        case CALL_BATCH_ROUTES:
         {
-            sys.listCrew();
+            vector<RouteQuery> queries = in.getQueries();
+            timed([&]
+                  { sys.batchRoutes(queries); });
+            break;
         }
-        else if (ch == 8)
+        case CALL_ROUTE_INDEX:
+        case CALL_DISTANCE_TABLE:
         {
-            sys.flightOccupancyReport();
+            bool enabled = in.getInt() != 0;
+            timed([&]
+                  {
+                if (code == CALL_ROUTE_INDEX)
+                    sys.setRouteIndexEnabled(enabled);
+                else
+                    sys.setDistanceTableEnabled(enabled); });
+            break;
         }
-        else if (ch == 9)
+        case CALL_QUALIFY_CREW:
         {
-            sys.waitlistReport();
+            int id = in.getInt();
+            string qualification = in.getString();
+            timed([&]
+                  { sys.qualifyCrew(id, qualification); });
+            break;
         }
-        else if (ch == 10)
+        case CALL_CREW_REQUIREMENTS:
         {
-            sys.printAllDuties();
+            int id = in.getInt();
+            vector<string> qualifications = in.getStrings();
+            timed([&]
+                  { sys.setCrewRequirements(id, qualifications); });
+            break;
         }
-        else if (ch == 11)
+        case CALL_QUERY_FLIGHTS:
         {
-            sys.checkCrewVacancy();
+            FlightQuery q = in.getFlightQuery();
+            timed([&]
+                  { sys.queryFlights(q); });
+            break;
+        }
+        case CALL_DELAY_FLIGHT:
+        {
+            int id = in.getInt(), departureDelay = in.getInt(), arrivalDelay = in.getInt();
+            timed([&]
+                  { sys.delayFlight(id, departureDelay, arrivalDelay); });
+            break;
+        }
+        case CALL_LIST_FLIGHTS:
+            timed([&]
+                  { sys.listFlights(); });
+            break;
+        case CALL_ASSIGN_CREW:
+            timed([&]
+                  { sys.assignCrewToAllFlights(); });
+            break;
+        case CALL_LIST_CREW:
+            timed([&]
+                  { sys.listCrew(); });
+            break;
+        case CALL_CREW_VACANCY:
+            timed([&]
+                  { sys.checkCrewVacancy(); });
+            break;
+        case CALL_OCCUPANCY_REPORT:
+            timed([&]
+                  { sys.flightOccupancyReport(); });
+            break;
+        case CALL_WAITLIST_REPORT:
+            timed([&]
+                  { sys.waitlistReport(); });
+            break;
+        case CALL_PRINT_DUTIES:
+            timed([&]
+                  { sys.printAllDuties(); });
+            break;
+        default:
+            break;
         }
+        if (in.truncated)
+            break;
+        replayed++;
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    if (in.truncated || !in.atEnd())
+        cerr << "Capture is truncated or corrupt; stopped after " << replayed << " calls.\n";
+
+    cout << left << setw(24) << "Call" << right << setw(10) << "Calls" << setw(12) << "Mean(us)"
+         << setw(12) << "p50(us)" << setw(12) << "p99(us)" << setw(12) << "Max(us)" << "\n";
+    cout << fixed << setprecision(1);
+    for (int c = 1; c < CALL_CODE_END; ++c)
+    {
+        if (calls[c] == 0)
+            continue;
+        cout << left << setw(24) << CALL_NAMES[c] << right << setw(10) << calls[c]
+             << setw(12) << totalNanos[c] / 1000.0 / calls[c]
+             << setw(12) << LatencyHistogram::percentile(histograms[c], calls[c], 0.50) / 1000.0
+             << setw(12) << LatencyHistogram::percentile(histograms[c], calls[c], 0.99) / 1000.0
+             << setw(12) << LatencyHistogram::percentile(histograms[c], calls[c], 1.0) / 1000.0 << "\n";
     }
+    cout << setprecision(3) << "Replayed " << replayed << " calls in " << seconds << " s ("
+         << (fast ? "as fast as possible" : "original pacing") << "; capture spans " << traceMicros / 1e6 << " s)\n";
+    return in.truncated ? 1 : 0;
 }
 
-void passengerMenu(AirlinesSystem &sys, string username)
+// ---------------------- Self Tests ----------------------
+// Correctness checks run with --selftest [name]. Each returns true on
+// success and says what went wrong on `log`; a test that hangs past the
+// watchdog fails the run. Exit status is non-zero if any test failed.
+struct SelfTest
 {
-    while (true)
+    const char *name;
+    bool (*run)(ostream &log);
+};
+
+// Back-to-back batches smaller than the pool, so workers are still leaving
+// one batch when the next is queued
+bool testPoolReuse(ostream &log)
+{
+    WorkStealingPool pool(4);
+    atomic<long long> ran(0);
+    vector<function<void()>> tasks(3, [&ran]()
+                                   { ran++; });
+    for (long long round = 1; round <= 100000; ++round)
     {
-        cout << "\n--- Passenger Menu ---\n";
-        cout << "1. Available Flights\n2. Search Flights by Route\n3. Search Flights by Time\n4. Book Flight\n";
-        cout << "5. Cancel Booking\n6. My Bookings\n7. Find Shortest Route\n8.Find Cheapest Route\n0. Logout\n";
-        int ch;
-        cin >> ch;
-        if (ch == 0)
-            break;
-        if (ch == 1)
+        pool.run(tasks);
+        if (ran.load() != round * 3)
         {
-            sys.listFlights();
+            log << "batch " << round << " finished with " << ran.load() << " tasks run, expected " << round * 3;
+            return false;
         }
-        if (ch == 2)
+    }
+    return true;
+}
+
+// Counts non-overlapping occurrences of `what` in `text`
+size_t occurrences(const string &text, const string &what)
+{
+    size_t n = 0;
+    for (size_t at = text.find(what); at != string::npos; at = text.find(what, at + what.size()))
+        n++;
+    return n;
+}
+
+// Accounts registered on the router are known to every shard, and bookings
+// stay on the shard that owns the flight
+bool testShardAccounts(ostream &log)
+{
+    string printed;
+    StringSink sink(printed);
+    ShardRouter router(4, &sink);
+    const char *origins[] = {"DEL", "MUM", "BLR", "MAA", "CCU", "HYD", "GOI", "COK"};
+    vector<int> ids;
+    for (int i = 0; i < 8; ++i)
+        ids.push_back(router.addFlight(origins[i], "XXX", 480, 600, 10, 4000));
+    router.registerPassenger("alice", "pw", "Alice");
+    router.bookFlight("alice", ids[0]);
+    router.bookFlight("alice", ids[5]);
+    printed.clear();
+    router.listPassengerBookings("alice");
+    if (occurrences(printed, "Passenger not found") || occurrences(printed, "Seat #") != 2)
+    {
+        log << "listing for a registered passenger printed:\n" << printed;
+        return false;
+    }
+    printed.clear();
+    router.bookFlight("mallory", ids[1]);
+    router.listPassengerBookings("mallory");
+    if (occurrences(printed, "Passenger not found") != 2 || occurrences(printed, "Seat booked"))
+    {
+        log << "an unknown passenger got:\n" << printed;
+        return false;
+    }
+    return true;
+}
+
+#if FLIGHTEASE_TRACING
+// Exports taken while other threads wrap their rings only show whole spans
+// (each writes ts == dur == id), and a new start() hides older sessions
+bool testTraceRings(ostream &log)
+{
+    TraceRecorder &recorder = TraceRecorder::instance();
+    recorder.start();
+    atomic<bool> done(false);
+    vector<thread> writers;
+    for (int w = 0; w < 3; ++w)
+        writers.emplace_back([&recorder]()
+                             {
+            for (long long k = 1; k < 400000; ++k)
+                recorder.record("selftest", 1000 * k, 2000 * k, k); });
+    thread stopper([&]()
+                   {
+        for (size_t w = 0; w < writers.size(); ++w)
+            writers[w].join();
+        done = true; });
+    const string expected = "\"name\":\"selftest\"";
+    bool ok = true;
+    for (int round = 0; ok && (round < 3 || !done); ++round)
+    {
+        ostringstream json;
+        recorder.exportJson(json);
+        string text = json.str();
+        for (size_t at = text.find("\"name\":"); at != string::npos; at = text.find("\"name\":", at + 1))
         {
-            string src, dest;
-            cout << "Source: ";
-            cin >> src;
-            cout << "Destination: ";
-            cin >> dest;
-            sys.searchFlights(src, dest);
+            size_t end = text.find('}', at);
+            string event = text.substr(at, end - at);
+            size_t ts = event.find("\"ts\":"), dur = event.find("\"dur\":"), id = event.find("\"id\":");
+            if (event.compare(0, expected.size(), expected) || ts == string::npos || dur == string::npos || id == string::npos ||
+                atof(event.c_str() + ts + 5) != atof(event.c_str() + dur + 6) || atof(event.c_str() + ts + 5) != atof(event.c_str() + id + 5))
+            {
+                log << "export " << round << " has a torn span: " << event;
+                ok = false;
+                break;
+            }
         }
-        else if (ch == 3)
+    }
+    stopper.join();
+    recorder.stop();
+    recorder.start();
+    ostringstream fresh;
+    size_t stale = recorder.exportJson(fresh);
+    recorder.stop();
+    if (ok && stale)
+    {
+        log << "a new recording still exported " << stale << " spans from the last one";
+        ok = false;
+    }
+    return ok;
+}
+#endif
+
+// Query result lines without the plan and the flight IDs, which shards number differently
+vector<string> matchLines(const string &printed)
+{
+    vector<string> lines;
+    istringstream in(printed);
+    for (string line; getline(in, line);)
+        if (!line.compare(0, 4, "ID: "))
+            lines.push_back(line.substr(line.find('|')));
+    return lines;
+}
+
+// A fan-out query through the router lists what one system holding every
+// flight would: one order across shards and the limit applied once
+bool testShardQueryMerge(ostream &log)
+{
+    string printed;
+    StringSink sink(printed);
+    ostream os(&sink);
+    ShardRouter router(4, &sink);
+    AirlinesSystem whole(os);
+    const char *origins[] = {"DEL", "MUM", "BLR", "MAA", "CCU", "HYD"};
+    for (int i = 0; i < 18; ++i)
+    {
+        int dep = 300 + 37 * i % 600, seats = 5 + i % 7, price = 2000 + 311 * (i * 7 % 18);
+        router.addFlight(origins[i % 6], origins[(i + 1) % 6], dep, dep + 90 + i, seats, price);
+        whole.addFlight(origins[i % 6], origins[(i + 1) % 6], dep, dep + 90 + i, seats, price);
+    }
+    const char *queries[] = {"sort=price limit=4", "sort=seats desc limit=5", "dep=400-800 limit=3",
+                             "to=MUM sort=duration", "sort=arrival desc"};
+    for (size_t i = 0; i < sizeof(queries) / sizeof(queries[0]); ++i)
+    {
+        FlightQuery q;
+        istringstream terms(queries[i]);
+        parseFlightQuery(terms, q);
+        printed.clear();
+        router.queryFlights(q);
+        vector<string> merged = matchLines(printed);
+        printed.clear();
+        whole.queryFlights(q);
+        vector<string> expected = matchLines(printed);
+        if (merged != expected || expected.empty())
         {
-            int dep1, dep2;
-            cout << "Earliest Departure (min): ";
-            cin >> dep1;
-            cout << "Latest Departure (min): ";
-            cin >> dep2;
-            sys.searchFlightsByTime(dep1, dep2);
+            log << "\"" << queries[i] << "\" gave " << merged.size() << " rows through the router, "
+                << expected.size() << " from one system";
+            return false;
         }
-        else if (ch == 4)
+    }
+    return true;
+}
+
+// A flight update drops the flight's holds: once the seat is booked again,
+// neither confirming nor expiring the old hold may touch it
+bool testUpdatedFlightHolds(ostream &log)
+{
+    for (int expire = 0; expire < 2; ++expire)
+    {
+        NullBuffer sink;
+        ostream quiet(&sink);
+        AirlinesSystem sys(quiet);
+        sys.pinClock(0);
+        int updated = sys.addFlight("AAA", "BBB", 480, 600, 2, 1000);
+        int other = sys.addFlight("AAA", "CCC", 500, 620, 2, 1000);
+        long long hold = sys.holdSeat("alice", updated);
+        sys.updateFlight(updated, 490, 610, 2, 1000);
+        sys.bookFlight("bob", updated); // takes the held seat number
+        if (expire)
         {
-            int fid;
-            cout << "Flight ID to book: ";
-            cin >> fid;
-            sys.bookFlight(username, fid);
+            sys.pinClock(601 * 1000);
+            sys.bookFlight("carol", other); // expires due holds
         }
-        else if (ch == 5)
+        else if (sys.confirmHold("alice", hold))
         {
-            int fid;
-            cout << "Flight ID to cancel: ";
-            cin >> fid;
-            sys.cancelBooking(username, fid);
+            log << "a hold from before the update was confirmed";
+            return false;
         }
-        else if (ch == 6)
+        long long expected = expire ? 2 : 1;
+        if (sys.seatsSold() != expected)
         {
-            sys.listPassengerBookings(username);
+            log << (expire ? "after the old hold expired " : "after the old hold was confirmed ")
+                << sys.seatsSold() << " seats are sold, expected " << expected;
+            return false;
         }
-        else if (ch == 7)
+    }
+    return true;
+}
+
+#if FLIGHTEASE_ALLOC_COUNTERS
+// Once warmed up, the query hot paths reuse their scratch memory and arenas:
+// a second round of the same calls makes no heap allocations
+bool testSteadyStateAllocations(ostream &log)
+{
+    NullBuffer sink;
+    ostream quiet(&sink);
+    AirlinesSystem sys(quiet);
+    const string codes[] = {"DEL", "MUM", "BLR", "MAA", "CCU", "HYD", "GOI"};
+    for (int i = 0; i < 7; ++i)
+    {
+        sys.addFlight(codes[i], codes[(i + 1) % 7], 300 + 10 * i, 380 + 17 * i, 50, 3000 + 400 * i);
+        sys.addFlight(codes[i], codes[(i + 3) % 7], 500 + 10 * i, 700 + 13 * i, 50, 9000 - 500 * i);
+    }
+    uint64_t allocations[2];
+    for (int round = 0; round < 2; ++round)
+    {
+        uint64_t before = heapAllocations();
+        for (int i = 0; i < 7; ++i)
         {
-            string src, dest;
-            cout << "Source: ";
-            cin >> src;
-            cout << "Destination: ";
-            cin >> dest;
-            sys.findShortestRoute(src, dest);
+            sys.findShortestRoute(codes[i], codes[(i + 5) % 7]);
+            sys.findCheapestRoute(codes[i], codes[(i + 4) % 7]);
+            sys.searchFlights(codes[i], codes[(i + 1) % 7]);
+            sys.searchFlightsByTime(300 + 20 * i, 600 + 20 * i);
+            sys.reachableFrom(codes[i], 300, i % 2 == 1);
         }
-        else if (ch == 8)
+        allocations[round] = heapAllocations() - before;
+    }
+    if (allocations[1])
+    {
+        log << "warm round made " << allocations[1] << " heap allocations (warm-up made " << allocations[0] << ")";
+        return false;
+    }
+    return true;
+}
+#endif
+
+// Itineraries must connect: each leg leaves from where the last one landed,
+// with time to transfer; a broken one books nothing
+bool testItineraryConnections(ostream &log)
+{
+    NullBuffer sink;
+    ostream quiet(&sink);
+    AirlinesSystem sys(quiet);
+    int first = sys.addFlight("DEL", "MUM", 480, 600, 5, 4000);
+    int tight = sys.addFlight("MUM", "BLR", 600 + MIN_CONNECTION_MINUTES - 1, 800, 5, 4000);
+    int elsewhere = sys.addFlight("BLR", "MAA", 700, 800, 5, 4000);
+    int onward = sys.addFlight("MUM", "BLR", 600 + MIN_CONNECTION_MINUTES, 800, 5, 4000);
+    vector<int> broken[] = {{first, tight}, {first, elsewhere}, {onward, first}};
+    for (int i = 0; i < 3; ++i)
+        if (sys.bookItinerary("alice", broken[i]) || sys.seatsSold() != 0)
         {
-            string src, dest;
-            cout << "Source: ";
-            cin >> src;
-            cout << "Destination: ";
-            cin >> dest;
-            sys.findCheapestRoute(src, dest);
+            log << "itinerary " << broken[i][0] << " -> " << broken[i][1] << " was booked";
+            return false;
+        }
+    if (!sys.bookItinerary("alice", {first, onward}) || sys.seatsSold() != 2)
+    {
+        log << "a " << MIN_CONNECTION_MINUTES << "-minute connection was refused";
+        return false;
+    }
+    return true;
+}
+
+// Systems with metrics recording off, as the benchmarks run them, leave the
+// process-wide report untouched
+bool testBenchmarkMetrics(ostream &log)
+{
+#if FLIGHTEASE_METRICS
+    ostringstream before, after, counted;
+    MetricsRegistry::instance().report(before);
+    NullBuffer sink;
+    ostream quiet(&sink);
+    AirlinesSystem sys(quiet);
+    sys.setMetricsRecording(false);
+    int id = sys.addFlight("DEL", "MUM", 480, 600, 10, 4000);
+    sys.bookFlight("bench", id);
+    sys.listFlights();
+    ShardRouter router(2, &sink);
+    router.setMetricsRecording(false);
+    router.bookFlight("bench", router.addFlight("DEL", "MUM", 480, 600, 10, 4000));
+    MetricsRegistry::instance().report(after);
+    if (after.str() != before.str())
+    {
+        log << "report changed from\n" << before.str() << "to\n" << after.str();
+        return false;
+    }
+    sys.setMetricsRecording(true);
+    sys.listFlights();
+    MetricsRegistry::instance().report(counted);
+    if (counted.str() == before.str())
+    {
+        log << "turning recording back on did not count listFlights";
+        return false;
+    }
+#else
+    (void)log;
+#endif
+    return true;
+}
+
+// Enabling the all-pairs table never blocks a route query: queries search
+// directly until the background build lands, then read the table, with the
+// same answers either way
+bool testDistanceTableFallback(ostream &log)
+{
+    string printed;
+    StringSink sink(printed);
+    ostream os(&sink);
+    AirlinesSystem sys(os);
+    const char *codes[] = {"DEL", "MUM", "BLR", "MAA", "CCU", "HYD", "GOI"};
+    for (int i = 0; i < 7; ++i)
+    {
+        sys.addFlight(codes[i], codes[(i + 1) % 7], 300 + 10 * i, 380 + 17 * i, 50, 3000 + 400 * i);
+        sys.addFlight(codes[i], codes[(i + 3) % 7], 500 + 10 * i, 700 + 13 * i, 50, 9000 - 500 * i);
+    }
+    sys.setDistanceTableEnabled(true);
+    vector<string> answers;
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        if (pass == 1)
+        {
+            for (int waited = 0; waited < 1000 && !occurrences(printed, "status: idle"); ++waited)
+            {
+                this_thread::sleep_for(chrono::milliseconds(10));
+                printed.clear();
+                sys.routeIndexReport();
+            }
+            if (printed.compare(0, 20, "Route Index Report:\n") || !occurrences(printed, "All-pairs table:") ||
+                occurrences(printed, "(stale)"))
+            {
+                log << "report after the build:\n" << printed;
+                return false;
+            }
+        }
+        printed.clear();
+        for (int i = 0; i < 7; ++i)
+        {
+            sys.findShortestRoute(codes[i], codes[(i + 5) % 7]);
+            sys.findCheapestRoute(codes[i], codes[(i + 4) % 7]);
+        }
+        answers.push_back(printed);
+    }
+    if (answers[0] != answers[1])
+    {
+        log << "direct search:\n" << answers[0] << "all-pairs table:\n" << answers[1];
+        return false;
+    }
+    return true;
+}
+
+// Reports and queries read snapshots and never expire holds themselves,
+// yet show a lapsed hold's seat as free, or handed to the waitlist, exactly
+// as the next writer will leave it
+bool testSnapshotHolds(ostream &log)
+{
+    string printed;
+    StringSink sink(printed);
+    ostream os(&sink);
+    AirlinesSystem sys(os);
+    sys.pinClock(0);
+    int waitlisted = sys.addFlight("AAA", "BBB", 480, 600, 2, 1000);
+    int open = sys.addFlight("AAA", "CCC", 500, 620, 1, 1000);
+    sys.holdSeat("alice", waitlisted);
+    sys.bookFlight("carol", waitlisted);
+    sys.bookFlight("bob", waitlisted);
+    sys.holdSeat("alice", open);
+    FlightQuery free;
+    free.minSeats = 1;
+
+    vector<string> seen;
+    for (int pass = 0; pass < 3; ++pass)
+    {
+        if (pass == 1)
+            sys.pinClock(601 * 1000); // past the default 600 s TTL
+        if (pass == 2)
+            sys.bookFlight("carol", 1); // any writer expires the holds for real
+        printed.clear();
+        sys.listFlights();
+        sys.waitlistReport();
+        sys.queryFlights(free);
+        seen.push_back(printed);
+    }
+    if (occurrences(seen[0], "Seats: 0/") != 2 || occurrences(seen[0], ": 1 on waitlist") != 1 ||
+        !occurrences(seen[0], "No flights match"))
+    {
+        log << "before the holds lapse:\n" << seen[0];
+        return false;
+    }
+    if (seen[1] != seen[2])
+    {
+        log << "readers after the holds lapsed:\n" << seen[1] << "after the writer expired them:\n" << seen[2];
+        return false;
+    }
+    if (occurrences(seen[1], "Seats: 1/1") != 2 || occurrences(seen[1], ": 1 on waitlist"))
+    {
+        log << "after the holds lapse:\n" << seen[1];
+        return false;
+    }
+    return true;
+}
+
+// The benchmark options cross-check their fast paths against a plain
+// implementation. These run them at a small size; every audit must pass.
+bool benchmarkAudit(ostream &log, const ostringstream &table, long long failures)
+{
+    if (failures == 0)
+        return true;
+    log << failures << " audit failure(s):\n" << table.str();
+    return false;
+}
+
+bool testRouteAudit(ostream &log)
+{
+    ostringstream table;
+    return benchmarkAudit(log, table, runRouteBenchmark(table, 300, 300));
+}
+
+bool testBatchRouteAudit(ostream &log)
+{
+    ostringstream table;
+    return benchmarkAudit(log, table, runBatchRouteBenchmark(table, 300, 400));
+}
+
+bool testGroupBookingAudit(ostream &log)
+{
+    ostringstream table;
+    return benchmarkAudit(log, table, runGroupBookingBenchmark(table, 60, 3));
+}
+
+bool testItineraryAudit(ostream &log)
+{
+    ostringstream table;
+    return benchmarkAudit(log, table, runItineraryBenchmark(table, 40, 2000));
+}
+
+bool testCrewFilterAudit(ostream &log)
+{
+    ostringstream table;
+    return benchmarkAudit(log, table, runCrewFilterBenchmark(table, 500, 500));
+}
+
+bool testFlightQueryAudit(ostream &log)
+{
+    ostringstream table;
+    return benchmarkAudit(log, table, runFlightQueryBenchmark(table, 2000, 600));
+}
+
+bool testSnapshotReadAudit(ostream &log)
+{
+    ostringstream table;
+    return benchmarkAudit(log, table, runSnapshotReadBenchmark(table, 40, 2000));
+}
+
+const SelfTest SELF_TESTS[] = {
+    {"pool-reuse", testPoolReuse},
+    {"shard-accounts", testShardAccounts},
+#if FLIGHTEASE_TRACING
+    {"trace-rings", testTraceRings},
+#endif
+    {"snapshot-holds", testSnapshotHolds},
+    {"updated-flight-holds", testUpdatedFlightHolds},
+    {"itinerary-connections", testItineraryConnections},
+    {"shard-query-merge", testShardQueryMerge},
+    {"distance-table-fallback", testDistanceTableFallback},
+    {"benchmark-metrics", testBenchmarkMetrics},
+#if FLIGHTEASE_ALLOC_COUNTERS
+    {"steady-state-allocations", testSteadyStateAllocations},
+#endif
+    {"route-audit", testRouteAudit},
+    {"batch-route-audit", testBatchRouteAudit},
+    {"group-booking-audit", testGroupBookingAudit},
+    {"itinerary-audit", testItineraryAudit},
+    {"crew-filter-audit", testCrewFilterAudit},
+    {"flight-query-audit", testFlightQueryAudit},
+    {"snapshot-read-audit", testSnapshotReadAudit},
+};
+
+int runSelfTests(const string &only)
+{
+    int failed = 0, run = 0;
+    for (size_t i = 0; i < sizeof(SELF_TESTS) / sizeof(SELF_TESTS[0]); ++i)
+    {
+        const SelfTest &t = SELF_TESTS[i];
+        if (!only.empty() && only != t.name)
+            continue;
+        mutex lock;
+        condition_variable finished;
+        bool over = false;
+        thread watchdog([&]()
+                        {
+            unique_lock<mutex> guard(lock);
+            if (!finished.wait_for(guard, chrono::seconds(120), [&]
+                                   { return over; }))
+            {
+                cout << "FAIL " << t.name << ": timed out" << endl;
+                _exit(1);
+            } });
+        ostringstream log;
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        bool ok = t.run(log);
+        {
+            lock_guard<mutex> guard(lock);
+            over = true;
         }
+        finished.notify_all();
+        watchdog.join();
+        run++;
+        failed += !ok;
+        cout << (ok ? "PASS " : "FAIL ") << t.name << " ("
+             << chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count() << " ms)";
+        if (!ok)
+            cout << ": " << log.str();
+        cout << endl;
+    }
+    if (run == 0)
+    {
+        cout << "No self test named " << only << ".\n";
+        return 1;
     }
+    cout << run - failed << "/" << run << " self tests passed.\n";
+    return failed ? 1 : 0;
 }
 
-int main()
+int main(int argc, char **argv)
 {
+#if FLIGHTEASE_METRICS
+    // FLIGHTEASE_METRICS_FILE=<path> [FLIGHTEASE_METRICS_INTERVAL=<seconds>] enables periodic dumps
+    unique_ptr<MetricsDumper> metricsDumper;
+    if (const char *path = getenv("FLIGHTEASE_METRICS_FILE"))
+    {
+        const char *interval = getenv("FLIGHTEASE_METRICS_INTERVAL");
+        metricsDumper.reset(new MetricsDumper(path, interval ? max(1, atoi(interval)) : 60));
+    }
+#endif
+    string mode = argc > 1 ? argv[1] : "";
+    if (mode == "--replay")
+    {
+        if (argc < 3)
+        {
+            cerr << "Usage: " << argv[0] << " --replay <capture> [--fast]\n";
+            return 1;
+        }
+        return runReplay(argv[2], argc > 3 && string(argv[3]) == "--fast");
+    }
+    if (mode == "--selftest")
+        return runSelfTests(argc > 2 ? argv[2] : "");
+
     AirlinesSystem sys;
-    // Preload some flights
-    sys.addFlight("DEL", "MUM", 480, 660, 3, 5000);
-    sys.addFlight("MUM", "BLR", 700, 900, 2, 4000);
-    sys.addFlight("DEL", "BLR", 500, 900, 1, 7000);
+    // FLIGHTEASE_CAPTURE_FILE=<path> records every call, starting with the default schedule
+    if (const char *path = getenv("FLIGHTEASE_CAPTURE_FILE"))
+    {
+        if (!sys.startCallCapture(path))
+            cerr << "Cannot write call capture " << path << endl;
+    }
+    loadDefaultSchedule(sys);
+
+    if (mode == "--serve" || mode == "--loadgen")
+    {
+#ifdef __linux__
+        string endpoint = argc > 2 ? argv[2] : "7070";
+        if (mode == "--serve")
+            return RequestServer(sys).run(endpoint);
+        int connections = argc > 3 ? max(1, atoi(argv[3])) : 8;
+        int requests = argc > 4 ? max(1, atoi(argv[4])) : 100000;
+        int depth = argc > 5 ? max(1, atoi(argv[5])) : 16;
+        return runLoadGenerator(endpoint, connections, requests, depth);
+#else
+        cerr << "The request server and load generator need Linux (epoll).\n";
+        return 1;
+#endif
+    }
+
     clearConsole();
     cout << endl;
     cout << "                 |  ____|| |     |_   _/ ____| |  | |__   __| |  ____|   /\\    / ____|  ____|" << endl;